@@ -0,0 +1,640 @@
+#include "allocations.hpp"
+#include "benchmark.hpp"
+#include "framewriter.hpp"
+#include "geometry.hpp"
+#include "jobsystem.hpp"
+#include "matrix.hpp"
+#include "meshgenerator.hpp"
+#include "renderer.hpp"
+#include "rendering.hpp"
+#include "renderscheduler.hpp"
+#include "scenes.hpp"
+#include "tgaimage.h"
+#include "transform.hpp"
+#include "trianglemesh.hpp"
+#include "trianglestream.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+Micro and macro benchmarks of the renderer, with no dependencies besides the bundled models.
+Usage (from the repository root):
+bench [--filter <text>] [--repetitions <n>] [--warmup <n>] [--min-time <ms>] [--sizes <n,n,...>] [--threads <n>]
+      [--max-triangles <n>] [--no-counters] [--json <file>] [model.obj]
+The micro benchmarks time the building blocks on fixed inputs. The macro benchmarks time every Scenes::draw_* path
+at each image size (square images, 300, 600 and 1200 by default) with the output discarded, except for the tiled
+render which always writes its TGA file. The scaling benchmarks render generated spheres, terrains and triangle soups
+(see generate_mesh) from 1K triangles up to --max-triangles (1M by default) in 600 x 600 images, and plot the throughput
+in triangles per second against the number of triangles. Benchmarks are named group/name[/size]; --filter keeps those
+containing the text. Where perf_event_open is allowed, each benchmark also reports its instructions per cycle and its
+instructions, cache misses and branch misses per item (see PerfCounters); --no-counters turns them off. The benchmarks
+that allocate print their allocations per repetition, and bench fails if a steady-state frame allocates (the steady_state group).
+*/
+
+// Run function with the standard error silenced, e.g. the statistics printed by the mesh loader
+template<typename Function>
+void quietly(Function function)
+{
+    std::cerr.setstate(std::ios::failbit);
+    function();
+    std::cerr.clear();
+}
+
+static std::string without_extension(const std::string& filename)
+{
+    return filename.substr(0, filename.rfind('.'));
+}
+
+static void micro_benchmarks(BenchmarkSuite& suite, const std::string& model_file, const TriangleMesh& model)
+{
+    // Geometry: every pixel of a 600 x 600 image against one triangle, as in the rasterizers
+    const std::array<Vector2i, 3> triangle{Vector2i{50, 20}, Vector2i{550, 120}, Vector2i{300, 580}};
+    suite.run("micro", "barycentric_coordinates", 600.0 * 600.0, [&triangle]()
+    {
+        float sum = 0.0f;
+        for (int y = 0; y < 600; ++y)
+        {
+            for (int x = 0; x < 600; ++x)
+            {
+                sum += barycentric_coordinates(triangle, Vector2i{x, y}).x;
+            }
+        }
+        do_not_optimize(sum);
+    });
+
+    // Matrix operations with the transforms used by Our GL
+    const int matrix_count = 10000;
+    const Matrix model_view_projection = projection(3.0f) * look_at(Vector3f{1, 1, 3}, Vector3f{0, 0, 0}, Vector3f{0, 1, 0});
+    Matrix matrix_3x3{3, 3};
+    matrix_3x3.fill_row(0, Vector3f{2, 0, 1});
+    matrix_3x3.fill_row(1, Vector3f{0, 3, 0});
+    matrix_3x3.fill_row(2, Vector3f{1, 0, 4});
+
+    suite.run("micro", "matrix_multiply_4x4", matrix_count, [&]()
+    {
+        float sum = 0.0f;
+        for (int i = 0; i < matrix_count; ++i)
+        {
+            sum += (model_view_projection * model_view_projection)[0][0];
+        }
+        do_not_optimize(sum);
+    });
+    suite.run("micro", "matrix_transform_vertex", matrix_count, [&]()
+    {
+        float sum = 0.0f;
+        for (int i = 0; i < matrix_count; ++i)
+        {
+            sum += homogeneous_to_cartesian(model_view_projection * cartesian_to_homogeneous(model.vertex(i % model.number_vertices()))).x;
+        }
+        do_not_optimize(sum);
+    });
+    suite.run("micro", "matrix_transpose_4x4", matrix_count, [&]()
+    {
+        float sum = 0.0f;
+        for (int i = 0; i < matrix_count; ++i)
+        {
+            sum += transpose(model_view_projection)[0][1];
+        }
+        do_not_optimize(sum);
+    });
+    suite.run("micro", "matrix_inverse_4x4", matrix_count, [&]()
+    {
+        float sum = 0.0f;
+        for (int i = 0; i < matrix_count; ++i)
+        {
+            sum += inverse_4x4(model_view_projection)[0][0];
+        }
+        do_not_optimize(sum);
+    });
+    suite.run("micro", "matrix_inverse_3x3", matrix_count, [&]()
+    {
+        float sum = 0.0f;
+        for (int i = 0; i < matrix_count; ++i)
+        {
+            sum += inverse_3x3(matrix_3x3)[0][0];
+        }
+        do_not_optimize(sum);
+    });
+
+    // Pixel access on a 600 x 600 RGB image
+    TGAImage image{600, 600, TGAImage::RGB};
+    suite.run("micro", "tgaimage_set", 600.0 * 600.0, [&image]()
+    {
+        const TGAColor color{200, 100, 50};
+        for (int y = 0; y < 600; ++y)
+        {
+            for (int x = 0; x < 600; ++x)
+            {
+                image.set(x, y, color);
+            }
+        }
+    });
+    suite.run("micro", "tgaimage_get", 600.0 * 600.0, [&image]()
+    {
+        float sum = 0.0f;
+        for (int y = 0; y < 600; ++y)
+        {
+            for (int x = 0; x < 600; ++x)
+            {
+                sum += image.get(x, y)[0];
+            }
+        }
+        do_not_optimize(sum);
+    });
+
+    // OBJ parsing alone, without the textures
+    MeshLoadOptions parse_options;
+    parse_options.load_textures = false;
+    suite.run("micro", "obj_parse", model.number_faces(), [&model_file, &parse_options]()
+    {
+        quietly([&]() { do_not_optimize(float(TriangleMesh{model_file, parse_options}.number_faces())); });
+    });
+
+    // Image encoding and decoding on the diffuse texture of the model
+    const std::string texture_file{without_extension(model_file) + "_diffuse.tga"};
+    TGAImage texture;
+    bool texture_loaded = false;
+    quietly([&]() { texture_loaded = texture.read_tga_file(texture_file.c_str()); });
+    if (texture_loaded)
+    {
+        const double texture_bytes = double(texture.get_width()) * texture.get_height() * texture.get_bytespp();
+        std::vector<unsigned char> encoded;
+        suite.run("micro", "tga_encode_rle", texture_bytes, [&]()
+        {
+            encoded.clear();
+            tga_rle_encode_bands(texture.buffer(), texture.get_width(), texture.get_height(), texture.get_bytespp(), 1, true, encoded);
+        });
+        suite.run("micro", "tga_decode_rle", texture_bytes, [&]()
+        {
+            TGAImage decoded;
+            quietly([&]() { decoded.read_tga_file(texture_file.c_str()); }); // the decoder logs the image size
+        });
+        suite.run("micro", "qoi_encode", texture_bytes, [&]()
+        {
+            encoded.clear();
+            qoi_encode(texture.buffer(), texture.get_width(), texture.get_height(), texture.get_bytespp(), false, encoded);
+        });
+
+        const std::string qoi_file{"bench_texture.qoi"};
+        if (suite.selected("micro", "qoi_decode") && texture.write_qoi_file(qoi_file.c_str()))
+        {
+            suite.run("micro", "qoi_decode", texture_bytes, [&]()
+            {
+                TGAImage decoded;
+                quietly([&]() { decoded.read_qoi_file(qoi_file.c_str()); });
+            });
+            std::remove(qoi_file.c_str());
+        }
+    }
+    else
+    {
+        std::fprintf(stderr, "Skipping the image benchmarks: cannot read %s\n", texture_file.c_str());
+    }
+
+    // Vertex shaders and rasterization of the whole model into a 600 x 600 context, the stages of render
+    for (const auto shader_choice: {ShadersOptions::Gouraud, ShadersOptions::BasicTexture, ShadersOptions::NormalMappingTexture, ShadersOptions::Phong})
+    {
+        RenderSettings settings;
+        settings.shader = shader_choice;
+        auto shader = make_shader(model, settings, 600, 600);
+        suite.run("micro", "vertex_" + shader_name(shader_choice), 3.0 * model.number_faces(), [&]()
+        {
+            float sum = 0.0f;
+            for (int face = 0; face < model.number_faces(); ++face)
+            {
+                for (int j = 0; j < 3; ++j)
+                {
+                    sum += shader->vertex(face, j).z;
+                }
+            }
+            do_not_optimize(sum);
+        });
+
+        if (!suite.selected("micro", "rasterize_" + shader_name(shader_choice)))
+        {
+            continue;
+        }
+
+        std::vector<std::array<Vector3f, 3>> screen_coordinates(model.number_faces());
+        std::vector<Varyings> face_varyings(model.number_faces());
+        for (int face = 0; face < model.number_faces(); ++face)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                screen_coordinates[face][j] = shader->vertex(face, j);
+            }
+            shader->save_varyings(face_varyings[face]);
+        }
+
+        // Per pixel of the image, fragment shading included
+        RenderContext context{600, 600};
+        suite.run("micro", "rasterize_" + shader_name(shader_choice), 600.0 * 600.0, [&]()
+        {
+            context.clear();
+            for (int face = 0; face < model.number_faces(); ++face)
+            {
+                shader->load_varyings(face_varyings[face]);
+                rasterize(screen_coordinates[face], *shader, context);
+            }
+            context.resolve();
+        });
+    }
+
+    // Fragment shaders, at four points of each of the first faces with the varyings of the face loaded
+    const int fragment_faces = std::min(model.number_faces(), 2048);
+    const std::array<Vector3f, 4> points{Vector3f{1.0f / 3, 1.0f / 3, 1.0f / 3}, Vector3f{0.6f, 0.2f, 0.2f},
+                                         Vector3f{0.2f, 0.6f, 0.2f}, Vector3f{0.2f, 0.2f, 0.6f}};
+    for (const auto shader_choice: {ShadersOptions::Gouraud, ShadersOptions::BasicTexture, ShadersOptions::NormalMappingTexture, ShadersOptions::Phong})
+    {
+        RenderSettings settings;
+        settings.shader = shader_choice;
+        auto shader = make_shader(model, settings, 600, 600);
+        std::vector<Varyings> varyings(fragment_faces);
+        for (int face = 0; face < fragment_faces; ++face)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                shader->vertex(face, j);
+            }
+            shader->save_varyings(varyings[face]);
+        }
+
+        suite.run("micro", "fragment_" + shader_name(shader_choice), 4.0 * fragment_faces, [&]()
+        {
+            float sum = 0.0f;
+            TGAColor color;
+            for (const auto& face_varyings: varyings)
+            {
+                shader->load_varyings(face_varyings);
+                for (const auto& point: points)
+                {
+                    shader->fragment(point, color);
+                    sum += color[0];
+                }
+            }
+            do_not_optimize(sum);
+        });
+    }
+}
+
+static void macro_benchmarks(BenchmarkSuite& suite, const std::string& model_file, const std::vector<int>& sizes, JobSystem& job_system)
+{
+    using Draw = std::function<void(Scenes&, RenderContext&, RenderScheduler&)>;
+    std::vector<std::pair<std::string, Draw>> draws{
+        {"draw_wire_mesh", [](Scenes& scenes, RenderContext& context, RenderScheduler&) { scenes.draw_wire_mesh(context); }},
+        {"draw_random_colored_triangles", [](Scenes& scenes, RenderContext& context, RenderScheduler&) { scenes.draw_random_colored_triangles(context); }},
+        {"draw_back_face_culling", [](Scenes& scenes, RenderContext& context, RenderScheduler&) { scenes.draw_back_face_culling(context); }},
+        {"draw_depth_buffer", [](Scenes& scenes, RenderContext& context, RenderScheduler&) { scenes.draw_depth_buffer(context); }},
+        {"draw_textured_depth_buffer", [](Scenes& scenes, RenderContext& context, RenderScheduler&) { scenes.draw_textured_depth_buffer(context); }},
+        {"draw_perspective_projection", [](Scenes& scenes, RenderContext& context, RenderScheduler&) { scenes.draw_perspective_projection(context); }},
+        {"draw_gouraud_shading", [](Scenes& scenes, RenderContext& context, RenderScheduler&) { scenes.draw_gouraud_shading(context); }},
+        {"draw_look_at", [](Scenes& scenes, RenderContext& context, RenderScheduler&) { scenes.draw_look_at(context); }}};
+
+    for (const auto shader_choice: {ShadersOptions::Gouraud, ShadersOptions::BasicTexture, ShadersOptions::NormalMappingTexture, ShadersOptions::Phong})
+    {
+        draws.emplace_back("draw_our_gl_" + shader_name(shader_choice), [shader_choice](Scenes& scenes, RenderContext& context, RenderScheduler&)
+        {
+            scenes.draw_our_gl(context, shader_choice);
+        });
+        draws.emplace_back("draw_our_gl_pipelined_" + shader_name(shader_choice), [shader_choice](Scenes& scenes, RenderContext& context, RenderScheduler&)
+        {
+            scenes.set_pipelined(true);
+            scenes.draw_our_gl(context, shader_choice);
+            scenes.set_pipelined(false);
+        });
+    }
+    draws.emplace_back("draw_our_gl_orbit_phong_4_views", [](Scenes& scenes, RenderContext&, RenderScheduler& scheduler)
+    {
+        scenes.draw_our_gl_orbit(scheduler, ShadersOptions::Phong, 4);
+        scheduler.wait();
+    });
+
+    const std::string stream_file{"bench_model.trs"};
+    bool stream_written = false;
+
+    for (const int size: sizes)
+    {
+        const std::string suffix{"/" + std::to_string(size)};
+        const bool tiled_selected = suite.selected("macro", "draw_our_gl_tiled_phong" + suffix);
+        const bool streamed_selected = suite.selected("macro", "draw_streamed_gouraud_shading" + suffix);
+        bool any_selected = tiled_selected || streamed_selected;
+        for (const auto& draw: draws)
+        {
+            any_selected = any_selected || suite.selected("macro", draw.first + suffix);
+        }
+        if (!any_selected)
+        {
+            continue;
+        }
+
+        MeshLoadOptions mesh_options;
+        mesh_options.job_system = &job_system;
+        std::unique_ptr<Scenes> scenes;
+        quietly([&]() { scenes = std::make_unique<Scenes>(model_file, mesh_options, size, size, &job_system); });
+        scenes->set_output_format(ImageFormat::None);
+        RenderContext context{size, size};
+        RenderScheduler scheduler{job_system, size, size};
+
+        for (const auto& draw: draws)
+        {
+            suite.run("macro", draw.first + suffix, double(size) * size, [&]()
+            {
+                draw.second(*scenes, context, scheduler);
+                scenes->wait_for_output();
+            });
+        }
+
+        if (tiled_selected)
+        {
+            suite.run("macro", "draw_our_gl_tiled_phong" + suffix, double(size) * size, [&]()
+            {
+                scenes->draw_our_gl_tiled(ShadersOptions::Phong, size, size);
+            });
+
+            // The tiled scene streams its tiles to a file whatever the output format
+            const std::string tiled_file{"9." + parse_filename(model_file) + "_our_gl_phong_" + std::to_string(size) + "x" + std::to_string(size) + ".tga"};
+            std::remove(tiled_file.c_str());
+        }
+
+        if (streamed_selected)
+        {
+            if (!stream_written)
+            {
+                quietly([&]() { stream_written = write_triangle_stream(TriangleMesh{model_file, MeshLoadOptions{}}, stream_file); });
+            }
+            suite.run("macro", "draw_streamed_gouraud_shading" + suffix, double(size) * size, [&]()
+            {
+                draw_streamed_gouraud_shading(stream_file, ImageFormat::None, size, size);
+            });
+        }
+    }
+
+    if (stream_written)
+    {
+        std::remove(stream_file.c_str());
+    }
+}
+
+// Count the events of the workers too: they run most of the macro and scaling benchmarks
+static void count_workers(BenchmarkSuite& suite, JobSystem& job_system)
+{
+    std::vector<int> thread_ids(job_system.number_threads(), -1);
+    JobCounter counter;
+    for (int i = 0; i < job_system.number_threads(); ++i)
+    {
+        job_system.submit([&thread_ids, i]() { thread_ids[i] = current_thread_id(); }, &counter, i);
+    }
+
+    job_system.wait(counter);
+    for (const int thread_id: thread_ids)
+    {
+        suite.count_thread(thread_id);
+    }
+}
+
+/*
+Steady-state allocation check: once a first frame has sized the targets, rendering a frame with Our GL into
+buffers reused across frames must not allocate. Prints the allocations per frame of each path and returns
+false if any path allocated; skipped when the counting operator new is not linked in (see allocations.hpp)
+*/
+static bool check_steady_state_allocations(BenchmarkSuite& suite, const TriangleMesh& model)
+{
+    if (!allocation_tracking_enabled())
+    {
+        std::fprintf(stderr, "Skipping the steady-state allocation check: allocations are not tracked\n");
+        return true;
+    }
+
+    const int frames = 3;
+    bool passed = true;
+    auto check = [&](const std::string& name, const std::function<void()>& frame)
+    {
+        if (!suite.selected("steady_state", name))
+        {
+            return;
+        }
+
+        frame(); // warm-up
+        const auto start = process_allocations();
+        for (int i = 0; i < frames; ++i)
+        {
+            frame();
+        }
+        const auto allocated = process_allocations() - start;
+        std::printf("steady_state/%-37s %s: %.4g allocations, %.4g bytes per frame\n", name.c_str(), allocated.allocations == 0 ? "passed" : "FAILED",
+                    double(allocated.allocations) / frames, double(allocated.bytes) / frames);
+        passed = passed && allocated.allocations == 0;
+    };
+
+    RenderContext context{600, 600};
+    TGAImage color{600, 600, TGAImage::RGB};
+    DepthBuffer depth;
+    for (const auto shader_choice: {ShadersOptions::Gouraud, ShadersOptions::BasicTexture, ShadersOptions::NormalMappingTexture, ShadersOptions::Phong})
+    {
+        RenderSettings settings;
+        settings.shader = shader_choice;
+        check("render_context_" + shader_name(shader_choice), [&]()
+        {
+            context.clear();
+            render(model, settings, context);
+        });
+        check("render_buffers_" + shader_name(shader_choice), [&]()
+        {
+            color.clear();
+            render(model, settings, color, &depth);
+        });
+    }
+    std::fflush(stdout);
+
+    return passed;
+}
+
+static void scaling_benchmarks(BenchmarkSuite& suite, std::int64_t max_triangles, JobSystem& job_system)
+{
+    const int size = 600;
+    const std::vector<std::pair<std::string, std::function<void(Scenes&, RenderContext&)>>> draws{
+        {"gouraud_shading", [](Scenes& scenes, RenderContext& context) { scenes.draw_gouraud_shading(context); }},
+        {"our_gl_phong", [](Scenes& scenes, RenderContext& context) { scenes.draw_our_gl(context, ShadersOptions::Phong); }}};
+
+    const std::size_t first = suite.results().size();
+    for (const auto shape: {GeneratedShape::Sphere, GeneratedShape::Terrain, GeneratedShape::Soup})
+    {
+        const std::string shape_name{shape == GeneratedShape::Sphere ? "sphere" : shape == GeneratedShape::Terrain ? "terrain" : "soup"};
+        for (std::int64_t triangles = 1000; triangles <= max_triangles; triangles *= 10)
+        {
+            const std::string suffix{"/" + std::to_string(triangles)};
+            const bool any_selected = std::any_of(draws.begin(), draws.end(), [&](const auto& draw)
+            {
+                return suite.selected("scaling", shape_name + "_" + draw.first + suffix);
+            });
+            if (!any_selected)
+            {
+                continue;
+            }
+
+            MeshGeneratorOptions generator_options;
+            generator_options.shape = shape;
+            generator_options.triangles = triangles;
+            MeshLoadOptions mesh_options;
+            mesh_options.job_system = &job_system;
+            std::unique_ptr<Scenes> scenes;
+            double faces = 0.0;
+            quietly([&]()
+            {
+                auto mesh = generate_mesh(generator_options, mesh_options);
+                faces = mesh.number_faces();
+                scenes = std::make_unique<Scenes>(std::move(mesh), shape_name, size, size, &job_system);
+            });
+            scenes->set_output_format(ImageFormat::None);
+            RenderContext context{size, size};
+
+            // The sphere and the terrain round the count to their grid, the throughput uses the actual one
+            for (const auto& draw: draws)
+            {
+                suite.run("scaling", shape_name + "_" + draw.first + suffix, faces, [&]()
+                {
+                    draw.second(*scenes, context);
+                    scenes->wait_for_output();
+                });
+            }
+        }
+    }
+
+    // Throughput of each series against the number of triangles, the bars relative to the fastest of the series
+    const auto& results = suite.results();
+    std::vector<std::string> series;
+    for (std::size_t i = first; i < results.size(); ++i)
+    {
+        const std::string name{results[i].name.substr(0, results[i].name.find('/'))};
+        if (std::find(series.begin(), series.end(), name) == series.end())
+        {
+            series.emplace_back(name);
+        }
+    }
+    for (const auto& name: series)
+    {
+        double fastest = 0.0;
+        for (std::size_t i = first; i < results.size(); ++i)
+        {
+            if (results[i].name.compare(0, name.size() + 1, name + "/") == 0)
+            {
+                fastest = std::max(fastest, results[i].items / results[i].median);
+            }
+        }
+
+        std::printf("\nscaling/%s (triangles per second)\n", name.c_str());
+        for (std::size_t i = first; i < results.size(); ++i)
+        {
+            if (results[i].name.compare(0, name.size() + 1, name + "/") != 0)
+            {
+                continue;
+            }
+            const double throughput = results[i].items / results[i].median;
+            const int bar = fastest > 0.0 ? static_cast<int>(throughput / fastest * 50.0 + 0.5) : 0;
+            std::printf("%12.0f %10.4g |%s\n", results[i].items, throughput * 1000.0, std::string(std::size_t(bar), '#').c_str());
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    BenchmarkOptions options;
+    std::string model_file{"obj/african_head/african_head.obj"};
+    std::string json_file;
+    std::vector<int> sizes{300, 600, 1200};
+    int threads = 0;
+    std::int64_t max_triangles = 1000000;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string argument{argv[i]};
+        if (argument == "--filter" && i + 1 < argc)
+        {
+            options.filter = argv[++i];
+        }
+        else if (argument == "--repetitions" && i + 1 < argc)
+        {
+            options.repetitions = std::stoi(argv[++i]);
+        }
+        else if (argument == "--warmup" && i + 1 < argc)
+        {
+            options.warmup = std::stoi(argv[++i]);
+        }
+        else if (argument == "--min-time" && i + 1 < argc)
+        {
+            options.min_time_ms = std::stod(argv[++i]);
+        }
+        else if (argument == "--sizes" && i + 1 < argc)
+        {
+            sizes.clear();
+            std::istringstream list{argv[++i]};
+            std::string size;
+            while (std::getline(list, size, ','))
+            {
+                sizes.emplace_back(std::stoi(size));
+            }
+        }
+        else if (argument == "--threads" && i + 1 < argc)
+        {
+            threads = std::stoi(argv[++i]);
+        }
+        else if (argument == "--no-counters")
+        {
+            options.hardware_counters = false;
+        }
+        else if (argument == "--max-triangles" && i + 1 < argc)
+        {
+            max_triangles = std::stoll(argv[++i]);
+        }
+        else if (argument == "--json" && i + 1 < argc)
+        {
+            json_file = argv[++i];
+        }
+        else
+        {
+            model_file = argument;
+        }
+    }
+
+#ifndef NDEBUG
+    std::fprintf(stderr, "Warning: assertions are enabled, configure with -DCMAKE_BUILD_TYPE=Release for representative timings\n");
+#endif
+
+    JobSystem job_system{threads};
+    std::unique_ptr<TriangleMesh> model;
+    quietly([&]() { model = std::make_unique<TriangleMesh>(model_file); });
+    if (model->number_faces() == 0)
+    {
+        std::fprintf(stderr, "Cannot load %s (run bench from the repository root)\n", model_file.c_str());
+        return 1;
+    }
+
+    BenchmarkSuite suite{options};
+    count_workers(suite, job_system);
+    const bool steady_state_passed = check_steady_state_allocations(suite, *model);
+    micro_benchmarks(suite, model_file, *model);
+    macro_benchmarks(suite, model_file, sizes, job_system);
+    scaling_benchmarks(suite, max_triangles, job_system);
+
+    if (!json_file.empty() && !suite.write_json(json_file))
+    {
+        std::fprintf(stderr, "Cannot write %s\n", json_file.c_str());
+        return 1;
+    }
+
+    if (!steady_state_passed)
+    {
+        std::fprintf(stderr, "Steady-state frames allocated, see the steady_state lines\n");
+        return 1;
+    }
+
+    return 0;
+}
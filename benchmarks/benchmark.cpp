@@ -0,0 +1,226 @@
+#include "benchmark.hpp"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+static volatile float sink;
+
+void do_not_optimize(float value)
+{
+    sink = value;
+}
+
+void summarize(const std::vector<double>& times, BenchmarkResult& result)
+{
+    result.repetitions = static_cast<int>(times.size());
+    if (times.empty())
+    {
+        return;
+    }
+
+    std::vector<double> sorted{times};
+    std::sort(sorted.begin(), sorted.end());
+    const std::size_t middle = sorted.size() / 2;
+    result.min = sorted.front();
+    result.max = sorted.back();
+    result.median = (sorted.size() % 2 == 1 ? sorted[middle] : (sorted[middle - 1] + sorted[middle]) / 2.0);
+
+    double sum = 0.0;
+    for (const auto time: sorted)
+    {
+        sum += time;
+    }
+    result.mean = sum / sorted.size();
+
+    double squares = 0.0;
+    for (const auto time: sorted)
+    {
+        squares += (time - result.mean) * (time - result.mean);
+    }
+    result.stddev = sorted.size() > 1 ? std::sqrt(squares / (sorted.size() - 1)) : 0.0;
+}
+
+// Instructions per cycle, and the counts per item: memory-bound code has a low IPC and many cache misses per item
+static void print_counters(const PerfSample& counters, double items)
+{
+    std::string line;
+    char field[64];
+    if (counters.has(PerfEvent::Cycles) && counters.has(PerfEvent::Instructions) && counters[PerfEvent::Cycles] > 0.0)
+    {
+        std::snprintf(field, sizeof(field), "ipc %.2f", counters[PerfEvent::Instructions] / counters[PerfEvent::Cycles]);
+        line += field;
+    }
+    for (int i = 0; i < number_perf_events && items > 0.0; ++i)
+    {
+        if (counters.available[i])
+        {
+            std::snprintf(field, sizeof(field), "%s%s/item %.4g", line.empty() ? "" : ", ", perf_event_name(PerfEvent(i)),
+                          counters.values[i] / items);
+            line += field;
+        }
+    }
+
+    if (!line.empty())
+    {
+        std::printf("    %s\n", line.c_str());
+    }
+}
+
+BenchmarkSuite::BenchmarkSuite(const BenchmarkOptions& options): options_{options}
+{
+    options_.repetitions = std::max(1, options_.repetitions);
+    options_.warmup = std::max(0, options_.warmup);
+    if (options_.hardware_counters)
+    {
+        counters_ = std::make_unique<PerfCounters>();
+        if (!counters_->available())
+        {
+            std::fprintf(stderr, "Hardware counters unavailable (%s), reporting times only\n", counters_->error().c_str());
+            counters_.reset();
+        }
+    }
+}
+
+void BenchmarkSuite::count_thread(int thread_id)
+{
+    if (counters_ && !counters_->add_thread(thread_id))
+    {
+        std::fprintf(stderr, "Hardware counters unavailable for thread %d, its events are reported as missing\n", thread_id);
+    }
+}
+
+bool BenchmarkSuite::selected(const std::string& group, const std::string& name) const
+{
+    return options_.filter.empty() || (group + "/" + name).find(options_.filter) != std::string::npos;
+}
+
+void BenchmarkSuite::run(const std::string& group, const std::string& name, double items, const std::function<void()>& function)
+{
+    if (!selected(group, name))
+    {
+        return;
+    }
+
+    for (int i = 0; i < options_.warmup; ++i)
+    {
+        function();
+    }
+
+    std::vector<double> times;
+    double total = 0.0;
+    AllocationCounts allocated; // by the repetitions only, not by the growth of times
+    const PerfSample counters_start = counters_ ? counters_->read() : PerfSample{};
+    while (static_cast<int>(times.size()) < options_.repetitions || total < options_.min_time_ms)
+    {
+        const auto allocations_start = process_allocations();
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        const auto end = std::chrono::steady_clock::now();
+        const auto allocations = process_allocations() - allocations_start;
+        allocated.allocations += allocations.allocations;
+        allocated.bytes += allocations.bytes;
+        times.emplace_back(std::chrono::duration<double, std::milli>(end - start).count());
+        total += times.back();
+    }
+
+    BenchmarkResult result;
+    result.group = group;
+    result.name = name;
+    result.items = items;
+    summarize(times, result);
+    result.allocations = double(allocated.allocations) / times.size();
+    result.allocated_bytes = double(allocated.bytes) / times.size();
+    if (counters_)
+    {
+        // The timing calls are included, a negligible fraction of a repetition
+        result.counters = counters_->read() - counters_start;
+        for (auto& value: result.counters.values)
+        {
+            value /= times.size();
+        }
+    }
+
+    if (results_.empty())
+    {
+        std::printf("%-50s %6s %10s %10s %10s %9s %10s %14s\n", "benchmark", "reps", "min (ms)", "median", "mean", "stddev", "max", "items/s");
+    }
+    std::printf("%-50s %6d %10.4f %10.4f %10.4f %9.4f %10.4f %14.4g\n", (group + "/" + name).c_str(), result.repetitions,
+                result.min, result.median, result.mean, result.stddev, result.max, result.median > 0.0 ? items / result.median * 1000.0 : 0.0);
+    print_counters(result.counters, items);
+    if (result.allocations > 0.0)
+    {
+        std::printf("    allocations/rep %.4g, allocated bytes/rep %.4g\n", result.allocations, result.allocated_bytes);
+    }
+    std::fflush(stdout);
+    results_.emplace_back(std::move(result));
+}
+
+const std::vector<BenchmarkResult>& BenchmarkSuite::results() const
+{
+    return results_;
+}
+
+static std::string json_string(const std::string& text)
+{
+    std::string quoted{"\""};
+    for (const char character: text)
+    {
+        if (character == '"' || character == '\\')
+        {
+            quoted += '\\';
+        }
+        quoted += character;
+    }
+
+    return quoted + "\"";
+}
+
+bool BenchmarkSuite::write_json(const std::string& filename) const
+{
+    std::ofstream output{filename};
+    if (!output.is_open())
+    {
+        return false;
+    }
+
+    output << "{\n";
+#ifdef NDEBUG
+    const bool release_build = true;
+#else
+    const bool release_build = false;
+#endif
+    output << "  \"context\": {\"hardware_threads\": " << std::thread::hardware_concurrency()
+           << ", \"ndebug\": " << (release_build ? "true" : "false") << ", \"warmup\": " << options_.warmup
+           << ", \"repetitions\": " << options_.repetitions << ", \"min_time_ms\": " << options_.min_time_ms
+           << ", \"filter\": " << json_string(options_.filter)
+           << ", \"hardware_counters\": " << (counters_ ? "true" : "false")
+           << ", \"allocation_tracking\": " << (allocation_tracking_enabled() ? "true" : "false") << "},\n";
+    output << "  \"benchmarks\": [";
+    for (std::size_t i = 0; i < results_.size(); ++i)
+    {
+        const auto& result = results_[i];
+        output << (i == 0 ? "\n" : ",\n");
+        output << "    {\"group\": " << json_string(result.group) << ", \"name\": " << json_string(result.name)
+               << ", \"repetitions\": " << result.repetitions << ", \"items\": " << result.items
+               << ", \"min_ms\": " << result.min << ", \"median_ms\": " << result.median << ", \"mean_ms\": " << result.mean
+               << ", \"stddev_ms\": " << result.stddev << ", \"max_ms\": " << result.max
+               << ", \"items_per_second\": " << (result.median > 0.0 ? result.items / result.median * 1000.0 : 0.0)
+               << ", \"allocations\": " << result.allocations << ", \"allocated_bytes\": " << result.allocated_bytes;
+        // Hardware event counts per repetition, only the available ones
+        output << ", \"counters\": {";
+        bool first = true;
+        for (int event = 0; event < number_perf_events; ++event)
+        {
+            if (result.counters.available[event])
+            {
+                output << (first ? "" : ", ") << json_string(perf_event_name(PerfEvent(event))) << ": " << result.counters.values[event];
+                first = false;
+            }
+        }
+        output << "}}";
+    }
+    output << "\n  ]\n}\n";
+
+    return static_cast<bool>(output);
+}
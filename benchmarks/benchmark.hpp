@@ -0,0 +1,86 @@
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include "allocations.hpp"
+#include "perfcounters.hpp"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Best time in milliseconds of repetitions calls of function, after one warm-up call
+template<typename Function>
+double best_time_ms(Function function, int repetitions = 10)
+{
+    function(); // warm-up
+    double best = 1e30;
+    for (int i = 0; i < repetitions; ++i)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        const auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    return best;
+}
+
+// Keep a computed value alive so the compiler cannot remove the code producing it
+void do_not_optimize(float value);
+
+// Statistics of the timed repetitions of a benchmark, in milliseconds
+struct BenchmarkResult
+{
+    std::string group; // e.g. "micro" or "macro"
+    std::string name;
+    double items{0.0}; // units of work per repetition (pixels, faces, bytes...), for the throughput
+    int repetitions{0};
+    double min{0.0};
+    double median{0.0};
+    double mean{0.0};
+    double stddev{0.0};
+    double max{0.0};
+    PerfSample counters; // hardware event counts per repetition, if available
+    double allocations{0.0}; // heap allocations per repetition, with allocation tracking (see allocations.hpp)
+    double allocated_bytes{0.0};
+};
+
+// Fill the statistics of result from the time of each repetition
+void summarize(const std::vector<double>& times, BenchmarkResult& result);
+
+struct BenchmarkOptions
+{
+    int warmup{1}; // untimed calls before the repetitions
+    int repetitions{10};
+    double min_time_ms{50.0}; // the repetitions continue until their total time reaches it
+    std::string filter; // only run the benchmarks whose "group/name" contains it
+    bool hardware_counters{true}; // count hardware events around the repetitions when the system allows it
+};
+
+class BenchmarkSuite
+{
+public:
+    explicit BenchmarkSuite(const BenchmarkOptions& options = BenchmarkOptions{});
+
+    // False if the filter excludes the benchmark, to skip its setup
+    bool selected(const std::string& group, const std::string& name) const;
+
+    // Time function, which performs items units of work per call, and print its statistics, hardware counts and allocations
+    void run(const std::string& group, const std::string& name, double items, const std::function<void()>& function);
+
+    // Include the thread with that kernel id in the hardware counts, e.g. a job system worker (see PerfCounters)
+    void count_thread(int thread_id);
+
+    const std::vector<BenchmarkResult>& results() const;
+
+    // Write the options and the results as JSON; returns false if the file cannot be written
+    bool write_json(const std::string& filename) const;
+private:
+    BenchmarkOptions options_;
+    std::unique_ptr<PerfCounters> counters_; // null if disabled or unavailable
+    std::vector<BenchmarkResult> results_;
+};
+
+#endif // BENCHMARK_HPP
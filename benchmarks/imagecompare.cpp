@@ -0,0 +1,120 @@
+#include "imagecompare.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+// Luma of each pixel; the buffer stores blue, green, red (and alpha)
+static std::vector<double> luma(const TGAImage& image)
+{
+    const int bytespp = image.get_bytespp();
+    const unsigned char* data = image.buffer();
+    std::vector<double> values(static_cast<std::size_t>(image.get_width()) * image.get_height());
+    for (std::size_t i = 0; i < values.size(); ++i)
+    {
+        const unsigned char* pixel = data + i * bytespp;
+        values[i] = bytespp >= 3 ? 0.114 * pixel[0] + 0.587 * pixel[1] + 0.299 * pixel[2] : pixel[0];
+    }
+
+    return values;
+}
+
+// Mean SSIM over non-overlapping 8 x 8 blocks (smaller along the right and top edges)
+static double structural_similarity(const TGAImage& reference, const TGAImage& image)
+{
+    const double c1 = (0.01 * 255) * (0.01 * 255);
+    const double c2 = (0.03 * 255) * (0.03 * 255);
+    const int block_size = 8;
+    const int width = image.get_width();
+    const int height = image.get_height();
+    const auto x = luma(reference);
+    const auto y = luma(image);
+
+    double total = 0.0;
+    int blocks = 0;
+    for (int block_y = 0; block_y < height; block_y += block_size)
+    {
+        for (int block_x = 0; block_x < width; block_x += block_size)
+        {
+            const int last_x = std::min(width, block_x + block_size);
+            const int last_y = std::min(height, block_y + block_size);
+            const double count = double(last_x - block_x) * (last_y - block_y);
+            double sum_x = 0.0, sum_y = 0.0, sum_xx = 0.0, sum_yy = 0.0, sum_xy = 0.0;
+            for (int j = block_y; j < last_y; ++j)
+            {
+                for (int i = block_x; i < last_x; ++i)
+                {
+                    const double a = x[i + j * width];
+                    const double b = y[i + j * width];
+                    sum_x += a;
+                    sum_y += b;
+                    sum_xx += a * a;
+                    sum_yy += b * b;
+                    sum_xy += a * b;
+                }
+            }
+
+            const double mean_x = sum_x / count;
+            const double mean_y = sum_y / count;
+            const double variance_x = sum_xx / count - mean_x * mean_x;
+            const double variance_y = sum_yy / count - mean_y * mean_y;
+            const double covariance = sum_xy / count - mean_x * mean_y;
+            total += ((2 * mean_x * mean_y + c1) * (2 * covariance + c2)) /
+                     ((mean_x * mean_x + mean_y * mean_y + c1) * (variance_x + variance_y + c2));
+            ++blocks;
+        }
+    }
+
+    return blocks > 0 ? total / blocks : 1.0;
+}
+
+ImageDifference compare_images(const TGAImage& reference, const TGAImage& image)
+{
+    ImageDifference difference;
+    if (reference.get_width() != image.get_width() || reference.get_height() != image.get_height() ||
+        reference.get_bytespp() != image.get_bytespp())
+    {
+        return difference;
+    }
+    difference.same_format = true;
+
+    const int bytespp = image.get_bytespp();
+    const std::size_t pixels = static_cast<std::size_t>(image.get_width()) * image.get_height();
+    double squared_error = 0.0;
+    for (std::size_t i = 0; i < pixels; ++i)
+    {
+        bool mismatched = false;
+        for (int channel = 0; channel < bytespp; ++channel)
+        {
+            const int delta = std::abs(int(reference.buffer()[i * bytespp + channel]) - int(image.buffer()[i * bytespp + channel]));
+            difference.max_channel_difference = std::max(difference.max_channel_difference, delta);
+            squared_error += double(delta) * delta;
+            mismatched = mismatched || delta != 0;
+        }
+        difference.mismatched_pixels += mismatched ? 1 : 0;
+    }
+
+    if (difference.mismatched_pixels > 0)
+    {
+        const double mean_squared_error = squared_error / (double(pixels) * bytespp);
+        difference.psnr = 10.0 * std::log10(255.0 * 255.0 / mean_squared_error);
+        difference.ssim = structural_similarity(reference, image);
+    }
+
+    return difference;
+}
+
+bool ImageTolerance::exact() const
+{
+    return std::isinf(min_psnr) && min_ssim >= 1.0;
+}
+
+bool ImageTolerance::accepts(const ImageDifference& difference) const
+{
+    if (!difference.same_format)
+    {
+        return false;
+    }
+
+    return exact() ? difference.mismatched_pixels == 0 : difference.psnr >= min_psnr && difference.ssim >= min_ssim;
+}
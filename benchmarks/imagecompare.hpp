@@ -0,0 +1,29 @@
+#ifndef IMAGE_COMPARE_HPP
+#define IMAGE_COMPARE_HPP
+
+#include "tgaimage.h"
+#include <limits>
+
+// Differences between a rendered image and its reference
+struct ImageDifference
+{
+    bool same_format{false}; // same dimensions and bytes per pixel; the other fields are only set if true
+    int mismatched_pixels{0};
+    int max_channel_difference{0};
+    double psnr{std::numeric_limits<double>::infinity()}; // dB over every channel, infinite for identical images
+    double ssim{1.0}; // mean structural similarity of the luma over 8 x 8 blocks, 1 for identical images
+};
+
+ImageDifference compare_images(const TGAImage& reference, const TGAImage& image);
+
+// Accepted differences: the defaults require identical images
+struct ImageTolerance
+{
+    double min_psnr{std::numeric_limits<double>::infinity()};
+    double min_ssim{1.0};
+
+    bool exact() const;
+    bool accepts(const ImageDifference& difference) const;
+};
+
+#endif // IMAGE_COMPARE_HPP
@@ -0,0 +1,227 @@
+#include "perfcounters.hpp"
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+const char* perf_event_name(PerfEvent event)
+{
+    static const char* const names[number_perf_events]{"cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses"};
+    return names[static_cast<int>(event)];
+}
+
+bool PerfSample::has(PerfEvent event) const
+{
+    return available[static_cast<int>(event)];
+}
+
+double PerfSample::operator[](PerfEvent event) const
+{
+    return values[static_cast<int>(event)];
+}
+
+PerfSample operator-(const PerfSample& end, const PerfSample& start)
+{
+    PerfSample difference;
+    for (int i = 0; i < number_perf_events; ++i)
+    {
+        difference.available[i] = end.available[i] && start.available[i];
+        difference.values[i] = difference.available[i] ? end.values[i] - start.values[i] : 0.0;
+    }
+
+    return difference;
+}
+
+#ifdef __linux__
+
+// Type and configuration of the perf_event_attr of each event
+static void event_attributes(PerfEvent event, perf_event_attr& attributes)
+{
+    attributes.type = PERF_TYPE_HARDWARE;
+    if (event == PerfEvent::Cycles)
+    {
+        attributes.config = PERF_COUNT_HW_CPU_CYCLES;
+    }
+    else if (event == PerfEvent::Instructions)
+    {
+        attributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+    }
+    else if (event == PerfEvent::L1DataMisses)
+    {
+        attributes.type = PERF_TYPE_HW_CACHE;
+        attributes.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    }
+    else if (event == PerfEvent::LastLevelMisses)
+    {
+        attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+    }
+    else
+    {
+        attributes.config = PERF_COUNT_HW_BRANCH_MISSES;
+    }
+}
+
+// Open the events counting thread_id (0 for the calling thread) on any CPU, without group: inherited
+// events cannot be read as a group. Returns the errno of the first event that could not be opened.
+static int open_events(int thread_id, bool inherit, std::array<int, number_perf_events>& descriptors)
+{
+    int error = 0;
+    descriptors.fill(-1);
+    for (int i = 0; i < number_perf_events; ++i)
+    {
+        perf_event_attr attributes;
+        std::memset(&attributes, 0, sizeof(attributes));
+        attributes.size = sizeof(attributes);
+        event_attributes(static_cast<PerfEvent>(i), attributes);
+        attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attributes.inherit = inherit ? 1 : 0;
+        attributes.exclude_kernel = 1; // allowed with perf_event_paranoid = 2
+        attributes.exclude_hv = 1;
+
+        descriptors[i] = static_cast<int>(syscall(SYS_perf_event_open, &attributes, thread_id, -1, -1, 0));
+        if (descriptors[i] < 0 && error == 0)
+        {
+            error = errno;
+        }
+    }
+
+    return error;
+}
+
+PerfCounters::PerfCounters(): threads_(1)
+{
+    // Inherited by the threads started later, e.g. the writer of a FrameWriter
+    const int error = open_events(0, true, threads_[0]);
+    if (!available() && error != 0)
+    {
+        error_ = std::strerror(error);
+    }
+}
+
+PerfCounters::~PerfCounters()
+{
+    for (const auto& descriptors: threads_)
+    {
+        for (const int descriptor: descriptors)
+        {
+            if (descriptor >= 0)
+            {
+                close(descriptor);
+            }
+        }
+    }
+}
+
+bool PerfCounters::add_thread(int thread_id)
+{
+    // Keep a thread that cannot be counted, its events are then missing rather than undercounted
+    Descriptors descriptors;
+    descriptors.fill(-1);
+    if (thread_id > 0)
+    {
+        open_events(thread_id, false, descriptors);
+    }
+
+    threads_.emplace_back(descriptors);
+    for (const int descriptor: descriptors)
+    {
+        if (descriptor >= 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+PerfSample PerfCounters::read() const
+{
+    // An event is available if every thread counts it, otherwise the sum would miss a thread
+    PerfSample sample;
+    sample.available.fill(true);
+    for (const auto& descriptors: threads_)
+    {
+        for (int i = 0; i < number_perf_events; ++i)
+        {
+            std::uint64_t values[3]{}; // count, time enabled, time running
+            if (descriptors[i] < 0 || ::read(descriptors[i], values, sizeof(values)) != static_cast<ssize_t>(sizeof(values)) ||
+                (values[1] != 0 && values[2] == 0))
+            {
+                sample.available[i] = false;
+                continue;
+            }
+
+            // Extrapolate the count over the time the event was multiplexed out; a thread which has
+            // not run since it was added has nothing to count
+            if (values[2] != 0)
+            {
+                sample.values[i] += double(values[0]) * double(values[1]) / double(values[2]);
+            }
+        }
+    }
+
+    for (int i = 0; i < number_perf_events; ++i)
+    {
+        if (!sample.available[i])
+        {
+            sample.values[i] = 0.0;
+        }
+    }
+
+    return sample;
+}
+
+int current_thread_id()
+{
+    return static_cast<int>(syscall(SYS_gettid));
+}
+
+#else
+
+PerfCounters::PerfCounters(): threads_(1), error_{"perf_event_open is only available on Linux"}
+{
+    threads_[0].fill(-1);
+}
+
+PerfCounters::~PerfCounters()
+{
+}
+
+bool PerfCounters::add_thread(int)
+{
+    return false;
+}
+
+PerfSample PerfCounters::read() const
+{
+    return PerfSample{};
+}
+
+int current_thread_id()
+{
+    return -1;
+}
+
+#endif // __linux__
+
+bool PerfCounters::available() const
+{
+    for (const int descriptor: threads_[0])
+    {
+        if (descriptor >= 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const std::string& PerfCounters::error() const
+{
+    return error_;
+}
@@ -0,0 +1,76 @@
+#ifndef PERF_COUNTERS_HPP
+#define PERF_COUNTERS_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Hardware events counted around the benchmarks
+enum class PerfEvent
+{
+    Cycles,
+    Instructions,
+    L1DataMisses, // L1 data cache read misses
+    LastLevelMisses, // last level cache misses
+    BranchMisses,
+    Count
+};
+
+constexpr int number_perf_events = static_cast<int>(PerfEvent::Count);
+
+// Name of the event in the reports, e.g. "l1d_misses"
+const char* perf_event_name(PerfEvent event);
+
+// Event counts over an interval; an event is missing if it could not be opened or was never scheduled
+struct PerfSample
+{
+    std::array<double, number_perf_events> values{};
+    std::array<bool, number_perf_events> available{};
+
+    bool has(PerfEvent event) const;
+    double operator[](PerfEvent event) const;
+};
+
+/*
+Hardware performance counters of the Linux perf_event_open interface, counting the calling thread, the
+threads added with add_thread, e.g. the job system workers, and the threads the calling thread starts
+afterwards once they have exited (the kernel folds inherited counts into the parent at exit, so a
+persistent thread must be added instead). Each event is opened on its own: the ones the CPU, the kernel
+or the container does not provide (perf_event_paranoid, seccomp, virtual machines) are reported as
+missing, and without perf_event_open (other systems) every event is. Counts are scaled when the kernel
+multiplexes them.
+*/
+class PerfCounters
+{
+public:
+    PerfCounters();
+    ~PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // True if at least one event could be opened
+    bool available() const;
+
+    // Why no event could be opened, e.g. "Permission denied"
+    const std::string& error() const;
+
+    // Also count the thread with that kernel id (see current_thread_id) from now on; false if no event could be opened
+    bool add_thread(int thread_id);
+
+    // Counts of all the threads since they were added; take the difference of two samples for an interval
+    PerfSample read() const;
+private:
+    using Descriptors = std::array<int, number_perf_events>;
+
+    std::vector<Descriptors> threads_; // the calling thread first, then the added threads
+    std::string error_;
+};
+
+// Kernel id of the calling thread for PerfCounters::add_thread, -1 without perf_event_open
+int current_thread_id();
+
+// Counts of end minus start, for the events available in both
+PerfSample operator-(const PerfSample& end, const PerfSample& start);
+
+#endif // PERF_COUNTERS_HPP
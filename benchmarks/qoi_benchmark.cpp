@@ -0,0 +1,88 @@
+#include "benchmark.hpp"
+#include "tgaimage.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/*
+Encode throughput and size of QOI against RLE TGA (TGAImage::write_tga_file), plus a lossless round trip check.
+Usage: qoi_benchmark [image.tga ...] (run from the repository root to use the bundled textures, or pass renders
+written by main e.g. qoi_benchmark 9.*.tga)
+*/
+
+long file_size(const std::string& filename)
+{
+    std::ifstream file{filename, std::ios::binary | std::ios::ate};
+    return file.is_open() ? static_cast<long>(file.tellg()) : -1;
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> files{"obj/african_head/african_head_diffuse.tga", "obj/african_head/african_head_nm_tangent.tga",
+                                   "obj/diablo3_pose/diablo3_pose_diffuse.tga", "obj/diablo3_pose/diablo3_pose_nm_tangent.tga"};
+    if (argc > 1)
+    {
+        files.assign(argv + 1, argv + argc);
+    }
+
+    const std::string tga_output{"qoi_benchmark_output.tga"};
+    const std::string qoi_output{"qoi_benchmark_output.qoi"};
+    std::printf("%-50s %10s %10s %12s %12s %12s %12s %9s\n", "image", "raw (KiB)", "TGA (KiB)", "QOI (KiB)", 
+                "TGA (MB/s)", "QOI (MB/s)", "QOI encode", "lossless");
+
+    std::cerr.setstate(std::ios::failbit); // silence the loaders
+    for (const auto& file: files)
+    {
+        TGAImage image;
+        if (!image.read_tga_file(file.c_str()))
+        {
+            std::printf("%-50s failed to load\n", file.c_str());
+            continue;
+        }
+
+        const int width = image.get_width();
+        const int height = image.get_height();
+        const int bytespp = image.get_bytespp();
+        const double raw_bytes = double(width) * height * bytespp;
+        const double megabytes = raw_bytes / (1024.0 * 1024.0);
+
+        const double tga_time = best_time_ms([&]() { image.write_tga_file(tga_output.c_str()); });
+        const double qoi_time = best_time_ms([&]() { image.write_qoi_file(qoi_output.c_str()); });
+        std::vector<unsigned char> encoded;
+        const double encode_time = best_time_ms([&]() 
+        {
+            encoded.clear();
+            qoi_encode(image.buffer(), width, height, bytespp, false, encoded);
+        });
+
+        // QOI has no grayscale channel layout, so grayscale images are compared against their RGB expansion
+        TGAImage decoded;
+        bool lossless = decoded.read_qoi_file(qoi_output.c_str()) && decoded.get_width() == width && decoded.get_height() == height;
+        for (int y = 0; lossless && y < height; ++y)
+        {
+            for (int x = 0; lossless && x < width; ++x)
+            {
+                const TGAColor expected = image.get(x, y);
+                const TGAColor actual = decoded.get(x, y);
+                for (int c = 0; c < decoded.get_bytespp(); ++c)
+                {
+                    lossless = lossless && actual.bgra[c] == (bytespp == TGAImage::GRAYSCALE ? expected.bgra[0] : expected.bgra[c]);
+                }
+            }
+        }
+
+        std::printf("%-50s %10.0f %10.0f %12.0f %12.1f %12.1f %12.1f %9s\n", file.c_str(), raw_bytes / 1024.0, 
+                    file_size(tga_output) / 1024.0, file_size(qoi_output) / 1024.0, megabytes / tga_time * 1000.0, 
+                    megabytes / qoi_time * 1000.0, megabytes / encode_time * 1000.0, lossless ? "yes" : "NO");
+    }
+    std::cerr.clear();
+
+    std::remove(tga_output.c_str());
+    std::remove(qoi_output.c_str());
+    std::printf("MB/s columns: uncompressed megabytes per second writing the file; QOI encode excludes file I/O\n");
+    return 0;
+}
@@ -0,0 +1,433 @@
+#include "benchmark.hpp"
+#include "imagecompare.hpp"
+#include "jobsystem.hpp"
+#include "renderer.hpp"
+#include "renderscheduler.hpp"
+#include "scenes.hpp"
+#include "tgaimage.h"
+#include "trianglemesh.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <regex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+Golden-image and performance regression check of the Scenes::draw_* outputs of the bundled models.
+Usage (from the repository root):
+regress [--update] [--golden <dir>] [--output <dir>] [--size <n>] [--threads <n>] [--repetitions <n>]
+        [--max-slowdown <fraction>] [--no-timings] [model.obj ...]
+Every scene is rendered once into the output directory (regress_output by default, whose TGA files are
+replaced), and its images are compared with the golden images of the same name (golden by default, committed
+at the default size of 300): exactly, or within the PSNR and SSIM tolerance of the scene for the float-heavy
+ones. Each scene is then timed without output, best of --repetitions, and compared with the timings stored
+next to the golden images (timings.json, not committed since it depends on the machine); a scene slower by
+more than --max-slowdown (0.25 by default, i.e. 25%), also when timed a second time, is flagged. Exits with 1
+if an image differs, a golden image is missing or a scene got slower. --update stores the images and timings
+of the current build as the new references instead, e.g. on the commit before an optimization, or after a
+change of the expected images. ctest runs it with --no-timings, and with the timings if CMake is configured
+with -DTINY_RENDERER_TIMING_TESTS=ON.
+*/
+
+namespace fs = std::filesystem;
+
+// A scene, the images it writes are compared with the tolerance
+struct RegressionScene
+{
+    std::string name;
+    std::function<void(Scenes&, RenderContext&, RenderScheduler&)> draw;
+    ImageTolerance tolerance;
+};
+
+// Run function with the standard error silenced, e.g. the statistics printed by the mesh and texture loaders
+template<typename Function>
+void quietly(Function function)
+{
+    std::cerr.setstate(std::ios::failbit);
+    function();
+    std::cerr.clear();
+}
+
+static std::vector<RegressionScene> regression_scenes(int size)
+{
+    /*
+    The first chapters only rasterize with integers and must match exactly; the later ones interpolate
+    in floating point, where e.g. vectorization or fused multiply-adds may change a few pixels
+    */
+    const ImageTolerance exact;
+    const ImageTolerance interpolated{40.0, 0.99};
+    const ImageTolerance shaded{35.0, 0.98};
+
+    std::vector<RegressionScene> scenes{
+        {"draw_wire_mesh", [](Scenes& scenes, RenderContext& context, RenderScheduler&) { scenes.draw_wire_mesh(context); }, exact},
+        {"draw_random_colored_triangles", [](Scenes& scenes, RenderContext& context, RenderScheduler&) { scenes.draw_random_colored_triangles(context); }, exact},
+        {"draw_back_face_culling", [](Scenes& scenes, RenderContext& context, RenderScheduler&) { scenes.draw_back_face_culling(context); }, exact},
+        {"draw_depth_buffer", [](Scenes& scenes, RenderContext& context, RenderScheduler&) { scenes.draw_depth_buffer(context); }, exact},
+        {"draw_textured_depth_buffer", [](Scenes& scenes, RenderContext& context, RenderScheduler&) { scenes.draw_textured_depth_buffer(context); }, interpolated},
+        {"draw_perspective_projection", [](Scenes& scenes, RenderContext& context, RenderScheduler&) { scenes.draw_perspective_projection(context); }, interpolated},
+        {"draw_gouraud_shading", [](Scenes& scenes, RenderContext& context, RenderScheduler&) { scenes.draw_gouraud_shading(context); }, interpolated},
+        {"draw_look_at", [](Scenes& scenes, RenderContext& context, RenderScheduler&) { scenes.draw_look_at(context); }, interpolated}};
+
+    for (const auto shader_choice: {ShadersOptions::Gouraud, ShadersOptions::BasicTexture, ShadersOptions::NormalMappingTexture, ShadersOptions::Phong})
+    {
+        scenes.push_back({"draw_our_gl_" + shader_name(shader_choice), [shader_choice](Scenes& scenes, RenderContext& context, RenderScheduler&)
+        {
+            scenes.draw_our_gl(context, shader_choice);
+        }, shaded});
+    }
+    scenes.push_back({"draw_our_gl_orbit_phong", [](Scenes& scenes, RenderContext&, RenderScheduler& scheduler)
+    {
+        scenes.draw_our_gl_orbit(scheduler, ShadersOptions::Phong, 4);
+        scheduler.wait();
+    }, shaded});
+    scenes.push_back({"draw_our_gl_tiled_phong", [size](Scenes& scenes, RenderContext&, RenderScheduler&)
+    {
+        scenes.draw_our_gl_tiled(ShadersOptions::Phong, size, size);
+    }, shaded});
+
+    return scenes;
+}
+
+// Names of the TGA files of a directory
+static std::set<std::string> tga_files(const fs::path& directory)
+{
+    std::set<std::string> files;
+    for (const auto& entry: fs::directory_iterator(directory))
+    {
+        if (entry.is_regular_file() && entry.path().extension() == ".tga")
+        {
+            files.insert(entry.path().filename().string());
+        }
+    }
+
+    return files;
+}
+
+// Stored timings: the image size they were measured at, and the scene timings in milliseconds keyed by "model/scene"
+struct StoredTimings
+{
+    int size{0};
+    std::map<std::string, double> scenes;
+};
+
+// Empty if the file does not exist
+static StoredTimings read_timings(const fs::path& filename)
+{
+    StoredTimings timings;
+    std::ifstream input{filename};
+    std::stringstream content;
+    content << input.rdbuf();
+    const std::string text{content.str()};
+
+    // The keys containing a '/' are scenes, the others are the settings of the run
+    const std::regex entry{"\"([^\"]+/[^\"]+)\"\\s*:\\s*([-+0-9.eE]+)"};
+    for (std::sregex_iterator match{text.begin(), text.end(), entry}; match != std::sregex_iterator{}; ++match)
+    {
+        timings.scenes[(*match)[1].str()] = std::stod((*match)[2].str());
+    }
+
+    std::smatch size;
+    if (std::regex_search(text, size, std::regex{"\"size\"\\s*:\\s*([0-9]+)"}))
+    {
+        timings.size = std::stoi(size[1].str());
+    }
+
+    return timings;
+}
+
+static bool write_timings(const fs::path& filename, const std::map<std::string, double>& timings, int size)
+{
+    std::ofstream output{filename};
+    if (!output.is_open())
+    {
+        return false;
+    }
+
+    output << "{\n  \"size\": " << size << ",\n  \"timings_ms\": {";
+    bool first = true;
+    for (const auto& timing: timings)
+    {
+        output << (first ? "\n" : ",\n") << "    \"" << timing.first << "\": " << timing.second;
+        first = false;
+    }
+    output << "\n  }\n}\n";
+
+    return static_cast<bool>(output);
+}
+
+// Compare the images written by a scene with their golden images; false if one differs or is missing
+static bool check_images(const std::string& key, const std::vector<std::string>& files, const ImageTolerance& tolerance,
+                         const fs::path& output_directory, const fs::path& golden_directory)
+{
+    bool passed = true;
+    for (const auto& file: files)
+    {
+        TGAImage golden;
+        TGAImage image;
+        bool read = false;
+        quietly([&]()
+        {
+            read = golden.read_tga_file((golden_directory / file).string().c_str()) &&
+                   image.read_tga_file((output_directory / file).string().c_str());
+        });
+        if (!read)
+        {
+            std::printf("FAILED  %-40s %s: no golden image (run with --update)\n", key.c_str(), file.c_str());
+            passed = false;
+            continue;
+        }
+
+        const auto difference = compare_images(golden, image);
+        const bool accepted = tolerance.accepts(difference);
+        passed = passed && accepted;
+        if (!difference.same_format)
+        {
+            std::printf("FAILED  %-40s %s: %dx%d/%d instead of %dx%d/%d\n", key.c_str(), file.c_str(), image.get_width(), image.get_height(),
+                        image.get_bytespp() * 8, golden.get_width(), golden.get_height(), golden.get_bytespp() * 8);
+        }
+        else if (difference.mismatched_pixels == 0)
+        {
+            std::printf("passed  %-40s %s: identical\n", key.c_str(), file.c_str());
+        }
+        else
+        {
+            char required[64];
+            if (tolerance.exact())
+            {
+                std::snprintf(required, sizeof(required), "exact required");
+            }
+            else
+            {
+                std::snprintf(required, sizeof(required), "min %g dB / %g", tolerance.min_psnr, tolerance.min_ssim);
+            }
+            std::printf("%s  %-40s %s: %d pixels differ (up to %d), psnr %.2f dB, ssim %.5f (%s)\n", accepted ? "passed" : "FAILED",
+                        key.c_str(), file.c_str(), difference.mismatched_pixels, difference.max_channel_difference, difference.psnr,
+                        difference.ssim, required);
+        }
+    }
+
+    return passed;
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> model_files;
+    fs::path golden_directory{"golden"};
+    fs::path output_directory{"regress_output"};
+    int size = 300; // the size of the committed golden images
+    int threads = 0;
+    int repetitions = 5;
+    double max_slowdown = 0.25;
+    bool update = false;
+    bool timings_enabled = true;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string argument{argv[i]};
+        if (argument == "--update")
+        {
+            update = true;
+        }
+        else if (argument == "--golden" && i + 1 < argc)
+        {
+            golden_directory = argv[++i];
+        }
+        else if (argument == "--output" && i + 1 < argc)
+        {
+            output_directory = argv[++i];
+        }
+        else if (argument == "--size" && i + 1 < argc)
+        {
+            size = std::stoi(argv[++i]);
+        }
+        else if (argument == "--threads" && i + 1 < argc)
+        {
+            threads = std::stoi(argv[++i]);
+        }
+        else if (argument == "--repetitions" && i + 1 < argc)
+        {
+            repetitions = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (argument == "--max-slowdown" && i + 1 < argc)
+        {
+            max_slowdown = std::stod(argv[++i]);
+        }
+        else if (argument == "--no-timings")
+        {
+            timings_enabled = false;
+        }
+        else
+        {
+            model_files.emplace_back(argument);
+        }
+    }
+    if (model_files.empty())
+    {
+        model_files = {"obj/african_head/african_head.obj", "obj/diablo3_pose/diablo3_pose.obj"};
+    }
+
+    fs::create_directories(output_directory);
+    for (const auto& file: tga_files(output_directory))
+    {
+        fs::remove(output_directory / file);
+    }
+
+    // Load every model first: the images are rendered before any timing, in the same order on every run
+    JobSystem job_system{threads};
+    MeshLoadOptions mesh_options;
+    mesh_options.job_system = &job_system;
+    std::vector<std::unique_ptr<Scenes>> models;
+    std::vector<std::string> model_names;
+    for (const auto& model_file: model_files)
+    {
+        std::unique_ptr<TriangleMesh> mesh;
+        quietly([&]() { mesh = std::make_unique<TriangleMesh>(model_file, mesh_options); });
+        if (mesh->number_faces() == 0)
+        {
+            std::fprintf(stderr, "Cannot load %s (run regress from the repository root)\n", model_file.c_str());
+            return 1;
+        }
+
+        model_names.emplace_back(parse_filename(model_file));
+        quietly([&]() { models.emplace_back(std::make_unique<Scenes>(std::move(*mesh), model_names.back(), size, size, &job_system)); });
+        models.back()->set_output_directory(output_directory.string());
+    }
+
+    const auto scenes = regression_scenes(size);
+    RenderContext context{size, size};
+    RenderScheduler scheduler{job_system, size, size};
+
+    // Images: the files a scene writes are the ones that were not in the output directory before it
+    std::vector<std::pair<std::string, std::vector<std::string>>> scene_files;
+    std::set<std::string> written;
+    bool passed = true;
+    for (std::size_t i = 0; i < models.size(); ++i)
+    {
+        auto& model = models[i];
+        for (const auto& scene: scenes)
+        {
+            const std::string key{model_names[i] + "/" + scene.name};
+            quietly([&]() { scene.draw(*model, context, scheduler); });
+            if (!model->wait_for_output())
+            {
+                std::fprintf(stderr, "Cannot write the images of %s to %s\n", key.c_str(), output_directory.string().c_str());
+                return 1;
+            }
+
+            std::vector<std::string> files;
+            for (const auto& file: tga_files(output_directory))
+            {
+                if (written.insert(file).second)
+                {
+                    files.emplace_back(file);
+                }
+            }
+            if (!update)
+            {
+                passed = check_images(key, files, scene.tolerance, output_directory, golden_directory) && passed;
+            }
+            scene_files.emplace_back(key, std::move(files));
+        }
+    }
+
+    // Timings, without writing the images (except for the tiled scene, which always streams its file)
+    std::map<std::string, std::function<double()>> timers;
+    std::map<std::string, double> timings;
+    if (timings_enabled)
+    {
+        for (std::size_t i = 0; i < models.size(); ++i)
+        {
+            auto& model = *models[i];
+            model.set_output_format(ImageFormat::None);
+            for (const auto& scene: scenes)
+            {
+                const std::string key{model_names[i] + "/" + scene.name};
+                timers[key] = [&, repetitions]()
+                {
+                    return best_time_ms([&]()
+                    {
+                        quietly([&]() { scene.draw(model, context, scheduler); });
+                        model.wait_for_output();
+                    }, repetitions);
+                };
+                timings[key] = timers[key]();
+            }
+        }
+    }
+
+    const fs::path timings_file{golden_directory / "timings.json"};
+    if (update)
+    {
+        fs::create_directories(golden_directory);
+        for (const auto& scene: scene_files)
+        {
+            for (const auto& file: scene.second)
+            {
+                fs::copy_file(output_directory / file, golden_directory / file, fs::copy_options::overwrite_existing);
+            }
+        }
+
+        // Keep the timings of the models not rendered by this run, unless they were measured at another size
+        auto stored_timings = read_timings(timings_file);
+        if (stored_timings.size != size)
+        {
+            stored_timings.scenes.clear();
+        }
+        for (const auto& timing: timings)
+        {
+            stored_timings.scenes[timing.first] = timing.second;
+        }
+        if (timings_enabled && !write_timings(timings_file, stored_timings.scenes, size))
+        {
+            std::fprintf(stderr, "Cannot write %s\n", timings_file.string().c_str());
+            return 1;
+        }
+        std::printf("Stored the images of %zu scenes%s in %s\n", scene_files.size(), timings_enabled ? " and their timings" : "",
+                    golden_directory.string().c_str());
+        return 0;
+    }
+
+    const auto baseline = read_timings(timings_file);
+    if (timings_enabled && baseline.scenes.empty())
+    {
+        std::printf("\nNo stored timings in %s: store them with --update to compare the timings\n", timings_file.string().c_str());
+    }
+    else if (timings_enabled && baseline.size != size)
+    {
+        std::printf("\nThe stored timings were measured at size %d, not %d: not compared\n", baseline.size, size);
+    }
+    else if (timings_enabled)
+    {
+        std::printf("\n%-48s %12s %12s %9s\n", "scene", "baseline ms", "current ms", "change");
+        for (auto& timing: timings)
+        {
+            const auto reference = baseline.scenes.find(timing.first);
+            if (reference == baseline.scenes.end())
+            {
+                std::printf("%-48s %12s %12.3f %9s\n", timing.first.c_str(), "-", timing.second, "new");
+                continue;
+            }
+
+            // A scene that looks slower is timed again before being flagged, short scenes are easily disturbed
+            if (timing.second / reference->second - 1.0 > max_slowdown)
+            {
+                timing.second = std::min(timing.second, timers[timing.first]());
+            }
+            const double change = timing.second / reference->second - 1.0;
+            const bool slower = change > max_slowdown;
+            passed = passed && !slower;
+            std::printf("%-48s %12.3f %12.3f %+8.1f%%%s\n", timing.first.c_str(), reference->second, timing.second, 100.0 * change,
+                        slower ? "  SLOWER" : "");
+        }
+    }
+
+    std::printf("\n%s\n", passed ? "No regression" : "Regressions found");
+    return passed ? 0 : 1;
+}
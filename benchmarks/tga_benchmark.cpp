@@ -0,0 +1,69 @@
+#include "benchmark.hpp"
+#include "tgaimage.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+Throughput of the TGA RLE encoders: serial TGAImage::write_tga_file against the band-parallel encoder.
+Usage: tga_benchmark [image.tga ...] (run from the repository root to use the bundled textures)
+*/
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> files{"obj/african_head/african_head_diffuse.tga", "obj/african_head/african_head_nm_tangent.tga",
+                                   "obj/diablo3_pose/diablo3_pose_diffuse.tga", "obj/diablo3_pose/diablo3_pose_nm_tangent.tga"};
+    if (argc > 1)
+    {
+        files.assign(argv + 1, argv + argc);
+    }
+
+    const int threads = std::max(1u, std::thread::hardware_concurrency());
+    const std::string output_file{"tga_benchmark_output.tga"};
+    std::printf("%-50s %12s %12s %12s %12s %10s\n", "image", "write (MB/s)", "write MT", "encode", "encode MT", "identical");
+
+    for (const auto& file: files)
+    {
+        TGAImage image;
+        std::cerr.setstate(std::ios::failbit); // silence the loader
+        const bool loaded = image.read_tga_file(file.c_str());
+        std::cerr.clear();
+        if (!loaded)
+        {
+            std::printf("%-50s failed to load\n", file.c_str());
+            continue;
+        }
+
+        const int width = image.get_width();
+        const int height = image.get_height();
+        const int bytespp = image.get_bytespp();
+        const double megabytes = double(width) * height * bytespp / (1024.0 * 1024.0);
+
+        const double write_serial = best_time_ms([&]() { image.write_tga_file(output_file.c_str(), true, 1); });
+        const double write_parallel = best_time_ms([&]() { image.write_tga_file(output_file.c_str(), true, threads); });
+
+        std::vector<unsigned char> serial_packets;
+        std::vector<unsigned char> parallel_packets;
+        const double encode_serial = best_time_ms([&]() 
+        { 
+            serial_packets.clear();
+            tga_rle_encode_bands(image.buffer(), width, height, bytespp, 1, true, serial_packets);
+        });
+        const double encode_parallel = best_time_ms([&]() 
+        {
+            parallel_packets.clear();
+            tga_rle_encode_bands(image.buffer(), width, height, bytespp, threads, true, parallel_packets);
+        });
+
+        std::printf("%-50s %12.1f %12.1f %12.1f %12.1f %10s\n", file.c_str(), megabytes / write_serial * 1000.0, 
+                    megabytes / write_parallel * 1000.0, megabytes / encode_serial * 1000.0, megabytes / encode_parallel * 1000.0,
+                    serial_packets == parallel_packets ? "yes" : "NO");
+    }
+
+    std::remove(output_file.c_str());
+    std::printf("threads: %d (MT columns); encode columns exclude file I/O and use packets that never cross rows\n", threads);
+    return 0;
+}
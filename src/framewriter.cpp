@@ -0,0 +1,134 @@
+#include "framewriter.hpp"
+#include "jobsystem.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+#include <iostream>
+
+bool write_image(const TGAImage& image, const std::string& filename, ImageFormat format, JobSystem* job_system)
+{
+    if (format == ImageFormat::None)
+    {
+        return true;
+    }
+
+    PROFILE_STAGE(OutputEncoding);
+    PROFILE_SCOPE("write_image " + filename);
+    if (format == ImageFormat::QOI)
+    {
+        return image.write_qoi_file((filename + ".qoi").c_str(), true);
+    }
+
+    // Rows are stored from the bottom of the image, so the origin bit is set instead of flipping the image
+    TGAStreamWriter writer{(filename + ".tga").c_str(), image.get_width(), image.get_height(), image.get_bytespp(), true, TGAStreamWriter::BOTTOM_UP};
+    if (job_system != nullptr)
+    {
+        writer.set_threads(job_system->number_threads(), [job_system](std::vector<std::function<void()>>& tasks)
+        {
+            JobCounter counter;
+            for (auto& task: tasks)
+            {
+                job_system->submit(std::move(task), &counter);
+            }
+            job_system->wait(counter);
+        });
+    }
+    else
+    {
+        writer.set_threads(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    return writer.write_rows(image.buffer(), image.get_height()) && writer.close();
+}
+
+FrameWriter::FrameWriter(int number_frames, JobSystem* job_system): 
+    number_frames_{std::max(1, number_frames)}, job_system_{job_system}
+{
+    writer_ = std::thread{&FrameWriter::write_frames, this};
+}
+
+FrameWriter::~FrameWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        stopping_ = true;
+    }
+    job_submitted_.notify_one();
+    writer_.join(); // the queue is drained before the writer thread exits
+}
+
+TGAImage FrameWriter::acquire_frame(int width, int height, int bytespp)
+{
+    std::unique_lock<std::mutex> lock{mutex_};
+    const bool running_job = JobSystem::running_job();
+    frame_released_.wait(lock, [this, running_job]()
+    {
+        return frames_in_use_ < number_frames_ || (running_job && pending_jobs_ == 0);
+    });
+    ++frames_in_use_;
+
+    while (!free_frames_.empty())
+    {
+        TGAImage frame{std::move(free_frames_.back())};
+        free_frames_.pop_back();
+        if (frame.get_width() == width && frame.get_height() == height && frame.get_bytespp() == bytespp)
+        {
+            return frame;
+        }
+    }
+
+    lock.unlock();
+    return TGAImage{width, height, bytespp};
+}
+
+void FrameWriter::submit(TGAImage&& frame, const std::string& filename, ImageFormat format)
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        jobs_.push_back(Job{std::move(frame), filename, format});
+        ++pending_jobs_;
+    }
+    job_submitted_.notify_one();
+}
+
+bool FrameWriter::wait()
+{
+    std::unique_lock<std::mutex> lock{mutex_};
+    frame_released_.wait(lock, [this]() { return pending_jobs_ == 0; });
+    const bool succeeded = !failed_;
+    failed_ = false;
+    return succeeded;
+}
+
+void FrameWriter::write_frames()
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock{mutex_};
+            job_submitted_.wait(lock, [this]() { return !jobs_.empty() || stopping_; });
+            if (jobs_.empty())
+            {
+                return;
+            }
+
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+
+        const bool written = write_image(job.frame, job.filename, job.format, job_system_);
+        job.frame.clear();
+
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            failed_ = failed_ || !written;
+            // Frames allocated beyond the pool by jobs are released instead of recycled
+            if (static_cast<int>(free_frames_.size()) < number_frames_)
+            {
+                free_frames_.push_back(std::move(job.frame));
+            }
+            --frames_in_use_;
+            --pending_jobs_;
+        }
+        frame_released_.notify_all();
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef FRAME_WRITER_HPP
+#define FRAME_WRITER_HPP
+
+#include "tgaimage.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Formats of the images written by the scenes
+enum class ImageFormat
+{
+    TGA, // RLE compressed TGA
+    QOI, // QOI: lossless, smaller and faster to encode than RLE on smooth shading
+    None // nothing is written, e.g. to time the rendering alone
+};
+
+class JobSystem;
+
+/*
+Write a rendered image (origin on the bottom left corner) to filename plus the extension of the format.
+The TGA encoding runs in parallel bands on the job system if given, otherwise on threads of its own
+*/
+bool write_image(const TGAImage& image, const std::string& filename, ImageFormat format = ImageFormat::TGA, 
+                 JobSystem* job_system = nullptr);
+
+/*
+Writes finished frames on a background thread so rendering overlaps with encoding and disk I/O.
+At most number_frames images exist at any time (two by default: one being rendered while the
+previous one is written); acquire_frame blocks while all of them are in use, which bounds memory
+and throttles the renderer when the disk cannot keep up. Written frames are cleared on the writer
+thread and recycled. Within a job, waiting is only safe while a frame is queued for writing, since
+the writer thread releases it whatever the jobs do: if every frame is held by renderers, a job
+allocates one more frame instead of deadlocking. Capping the render jobs in flight below the number
+of frames (see RenderScheduler) keeps that from happening.
+*/
+class FrameWriter
+{
+public:
+    explicit FrameWriter(int number_frames = 2, JobSystem* job_system = nullptr);
+    ~FrameWriter();
+    FrameWriter(const FrameWriter&) = delete;
+    FrameWriter& operator=(const FrameWriter&) = delete;
+
+    // Blocks until a frame is available; the frame is cleared (all zeros)
+    TGAImage acquire_frame(int width, int height, int bytespp);
+
+    // Takes ownership of a finished frame and queues it for writing; returns without waiting for the write
+    void submit(TGAImage&& frame, const std::string& filename, ImageFormat format);
+
+    // Blocks until every submitted frame is written; returns false if any write failed since the last call
+    bool wait();
+private:
+    struct Job
+    {
+        TGAImage frame;
+        std::string filename;
+        ImageFormat format;
+    };
+
+    void write_frames();
+
+    const int number_frames_;
+    JobSystem* job_system_;
+    int frames_in_use_{0}; // acquired by the renderer or waiting to be written
+    int pending_jobs_{0}; // submitted and not written yet
+    bool failed_{false};
+    bool stopping_{false};
+    std::deque<Job> jobs_;
+    std::vector<TGAImage> free_frames_;
+    std::mutex mutex_;
+    std::condition_variable job_submitted_;
+    std::condition_variable frame_released_;
+    std::thread writer_;
+};
+
+#endif // FRAME_WRITER_HPP
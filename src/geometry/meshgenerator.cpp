@@ -0,0 +1,289 @@
+#include "meshgenerator.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Pseudo-random value in [-1, 1] attached to a point of the integer lattice
+static float lattice_value(int x, int z, std::uint32_t seed)
+{
+    std::uint32_t hash = static_cast<std::uint32_t>(x) * 0x8DA6B343u ^ static_cast<std::uint32_t>(z) * 0xD8163841u ^ seed * 0xCB1AB31Fu;
+    hash ^= hash >> 13;
+    hash *= 0x5BD1E995u;
+    hash ^= hash >> 15;
+    return static_cast<float>(hash) / 4294967295.0f * 2.0f - 1.0f;
+}
+
+// Value noise: lattice values blended with a smoothstep
+static float value_noise(float x, float z, std::uint32_t seed)
+{
+    const float cell_x = std::floor(x);
+    const float cell_z = std::floor(z);
+    const int ix = static_cast<int>(cell_x);
+    const int iz = static_cast<int>(cell_z);
+    const float tx = (x - cell_x) * (x - cell_x) * (3.0f - 2.0f * (x - cell_x));
+    const float tz = (z - cell_z) * (z - cell_z) * (3.0f - 2.0f * (z - cell_z));
+
+    const float top = lattice_value(ix, iz, seed) + tx * (lattice_value(ix + 1, iz, seed) - lattice_value(ix, iz, seed));
+    const float bottom = lattice_value(ix, iz + 1, seed) + tx * (lattice_value(ix + 1, iz + 1, seed) - lattice_value(ix, iz + 1, seed));
+    return top + tz * (bottom - top);
+}
+
+// Four octaves of value noise, in [-1, 1]
+static float terrain_height(float x, float z, std::uint32_t seed)
+{
+    float height = 0.0f;
+    float frequency = 2.0f;
+    float amplitude = 0.5f;
+    for (int octave = 0; octave < 4; ++octave)
+    {
+        height += amplitude * value_noise(x * frequency, z * frequency, seed + octave);
+        frequency *= 2.0f;
+        amplitude *= 0.5f;
+    }
+
+    return height / 0.9375f;
+}
+
+static TriangleMesh generate_sphere(std::int64_t triangles, const MeshLoadOptions& load_options)
+{
+    // Twice as many slices as stacks, one triangle per slice on the polar stacks: 4 * stacks * (stacks - 1) triangles
+    const int stacks = std::max(2, static_cast<int>(std::lround((1.0 + std::sqrt(1.0 + double(triangles))) / 2.0)));
+    const int slices = 2 * stacks;
+    const float pi = std::acos(-1.0f);
+
+    // The seam column is duplicated for the uvs
+    std::vector<Vector3f> positions;
+    std::vector<Vector2f> uvs;
+    positions.reserve(std::size_t(stacks + 1) * (slices + 1));
+    uvs.reserve(positions.capacity());
+    for (int i = 0; i <= stacks; ++i)
+    {
+        const float theta = pi * i / stacks;
+        for (int j = 0; j <= slices; ++j)
+        {
+            const float phi = 2.0f * pi * j / slices;
+            positions.emplace_back(Vector3f{std::sin(theta) * std::sin(phi), std::cos(theta), std::sin(theta) * std::cos(phi)});
+            uvs.emplace_back(Vector2f{float(j) / slices, 1.0f - float(i) / stacks});
+        }
+    }
+    std::vector<Vector3f> normals{positions};
+
+    // Counter-clockwise seen from outside
+    const auto vertex = [slices](int i, int j) { return static_cast<std::uint32_t>(i * (slices + 1) + j); };
+    std::vector<std::uint32_t> indices;
+    indices.reserve(std::size_t(12) * stacks * (stacks - 1));
+    for (int i = 0; i < stacks; ++i)
+    {
+        for (int j = 0; j < slices; ++j)
+        {
+            if (i == stacks - 1)
+            {
+                indices.insert(indices.end(), {vertex(i, j), vertex(i + 1, j), vertex(i, j + 1)});
+                continue;
+            }
+
+            indices.insert(indices.end(), {vertex(i, j), vertex(i + 1, j), vertex(i + 1, j + 1)});
+            if (i > 0)
+            {
+                indices.insert(indices.end(), {vertex(i, j), vertex(i + 1, j + 1), vertex(i, j + 1)});
+            }
+        }
+    }
+
+    return TriangleMesh{std::move(positions), std::move(uvs), std::move(normals), std::move(indices), load_options};
+}
+
+static TriangleMesh generate_terrain(std::int64_t triangles, float roughness, std::uint32_t seed, const MeshLoadOptions& load_options)
+{
+    // n x n quads of two triangles over [-1, 1] x [-1, 1]
+    const int n = std::max(1, static_cast<int>(std::lround(std::sqrt(double(triangles) / 2.0))));
+    const float spacing = 2.0f / n;
+    const auto height = [roughness, seed](float x, float z) { return roughness * terrain_height(x, z, seed); };
+
+    std::vector<Vector3f> positions;
+    std::vector<Vector2f> uvs;
+    std::vector<Vector3f> normals;
+    positions.reserve(std::size_t(n + 1) * (n + 1));
+    uvs.reserve(positions.capacity());
+    normals.reserve(positions.capacity());
+    for (int i = 0; i <= n; ++i)
+    {
+        const float z = -1.0f + i * spacing;
+        for (int j = 0; j <= n; ++j)
+        {
+            const float x = -1.0f + j * spacing;
+            positions.emplace_back(Vector3f{x, height(x, z), z});
+            uvs.emplace_back(Vector2f{float(j) / n, float(i) / n});
+
+            // The normal of the height field y = h(x, z) is (-dh/dx, 1, -dh/dz)
+            const float slope_x = (height(x + spacing, z) - height(x - spacing, z)) / (2.0f * spacing);
+            const float slope_z = (height(x, z + spacing) - height(x, z - spacing)) / (2.0f * spacing);
+            normals.emplace_back(unit_vector(Vector3f{-slope_x, 1.0f, -slope_z}));
+        }
+    }
+
+    // Counter-clockwise seen from above
+    const auto vertex = [n](int i, int j) { return static_cast<std::uint32_t>(i * (n + 1) + j); };
+    std::vector<std::uint32_t> indices;
+    indices.reserve(std::size_t(6) * n * n);
+    for (int i = 0; i < n; ++i)
+    {
+        for (int j = 0; j < n; ++j)
+        {
+            indices.insert(indices.end(), {vertex(i, j), vertex(i + 1, j), vertex(i + 1, j + 1),
+                                           vertex(i, j), vertex(i + 1, j + 1), vertex(i, j + 1)});
+        }
+    }
+
+    return TriangleMesh{std::move(positions), std::move(uvs), std::move(normals), std::move(indices), load_options};
+}
+
+static TriangleMesh generate_soup(std::int64_t triangles, float triangle_size, std::uint32_t seed, const MeshLoadOptions& load_options)
+{
+    // Equilateral triangles of area sqrt(3) / 4 * size^2: by default their total area is about the area of a face of the cube
+    triangles = std::max<std::int64_t>(1, triangles);
+    const float size = triangle_size > 0.0f ? triangle_size : std::min(0.5f, 3.0f / std::sqrt(float(triangles)));
+    const float radius = size / std::sqrt(3.0f);
+    const float pi = std::acos(-1.0f);
+
+    std::mt19937 generator{seed};
+    const float margin = std::min(radius, 0.5f); // keeps the triangles inside of the cube unless they are larger
+    std::uniform_real_distribution<float> coordinate{-1.0f + margin, 1.0f - margin};
+    std::uniform_real_distribution<float> unit{-1.0f, 1.0f};
+    std::uniform_real_distribution<float> angle{0.0f, 2.0f * pi};
+
+    std::vector<Vector3f> positions;
+    std::vector<Vector2f> uvs;
+    std::vector<Vector3f> normals;
+    std::vector<std::uint32_t> indices;
+    positions.reserve(3 * triangles);
+    uvs.reserve(3 * triangles);
+    normals.reserve(3 * triangles);
+    indices.reserve(3 * triangles);
+    for (std::int64_t t = 0; t < triangles; ++t)
+    {
+        const Vector3f center{coordinate(generator), coordinate(generator), coordinate(generator)};
+
+        // Uniform normal direction, by rejection in the unit ball
+        Vector3f normal;
+        do
+        {
+            normal = Vector3f{unit(generator), unit(generator), unit(generator)};
+        } while (normal.length() > 1.0 || normal.length() < 1e-3);
+        normal = unit_vector(normal);
+
+        // Orthonormal basis of the plane of the triangle, vertices counter-clockwise around the normal
+        const Vector3f axis = std::abs(normal.x) < 0.9f ? Vector3f{1, 0, 0} : Vector3f{0, 1, 0};
+        const Vector3f tangent = unit_vector(cross(axis, normal));
+        const Vector3f bitangent = cross(normal, tangent);
+        const float rotation = angle(generator);
+        for (int k = 0; k < 3; ++k)
+        {
+            const float vertex_angle = rotation + 2.0f * pi * k / 3.0f;
+            const Vector3f position = center + radius * (std::cos(vertex_angle) * tangent + std::sin(vertex_angle) * bitangent);
+            indices.emplace_back(static_cast<std::uint32_t>(positions.size()));
+            positions.emplace_back(position);
+            uvs.emplace_back(Vector2f{(position.x + 1.0f) / 2.0f, (position.y + 1.0f) / 2.0f});
+            normals.emplace_back(normal);
+        }
+    }
+
+    return TriangleMesh{std::move(positions), std::move(uvs), std::move(normals), std::move(indices), load_options};
+}
+
+TriangleMesh generate_mesh(const MeshGeneratorOptions& options, const MeshLoadOptions& load_options)
+{
+    if (options.shape == GeneratedShape::Terrain)
+    {
+        return generate_terrain(options.triangles, options.roughness, options.seed, load_options);
+    }
+    else if (options.shape == GeneratedShape::Soup)
+    {
+        return generate_soup(options.triangles, options.triangle_size, options.seed, load_options);
+    }
+
+    return generate_sphere(options.triangles, load_options);
+}
+
+bool parse_generated_shape(const std::string& name, GeneratedShape& shape)
+{
+    if (name == "sphere")
+    {
+        shape = GeneratedShape::Sphere;
+    }
+    else if (name == "terrain")
+    {
+        shape = GeneratedShape::Terrain;
+    }
+    else if (name == "soup")
+    {
+        shape = GeneratedShape::Soup;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+bool write_obj_file(const TriangleMesh& mesh, const std::string& filename)
+{
+    if (!mesh.has_unified_vertices())
+    {
+        std::cerr << "write_obj_file: only meshes with unified vertices can be written\n";
+        return false;
+    }
+
+    std::ofstream output{filename, std::ios::binary};
+    if (!output.is_open())
+    {
+        std::cerr << "can't open file " << filename << "\n";
+        return false;
+    }
+
+    // Formatted by hand: streaming the floats one by one is several times slower on large meshes
+    std::vector<char> buffer(1 << 20);
+    std::size_t used = 0;
+    const auto append = [&](const char* format, auto... values)
+    {
+        if (buffer.size() - used < 256)
+        {
+            output.write(buffer.data(), static_cast<std::streamsize>(used));
+            used = 0;
+        }
+        used += static_cast<std::size_t>(std::snprintf(buffer.data() + used, buffer.size() - used, format, values...));
+    };
+
+    for (int i = 0; i < mesh.number_vertices(); ++i)
+    {
+        const auto position = mesh.vertex(i);
+        append("v %.6g %.6g %.6g\n", position.x, position.y, position.z);
+    }
+    for (int i = 0; i < mesh.number_vertices(); ++i)
+    {
+        const auto uv = mesh.uv(i);
+        append("vt %.6g %.6g 0\n", uv.x, uv.y);
+    }
+    for (int i = 0; i < mesh.number_vertices(); ++i)
+    {
+        const auto normal = mesh.normal(i);
+        append("vn %.6g %.6g %.6g\n", normal.x, normal.y, normal.z);
+    }
+
+    const auto& indices = mesh.indices();
+    for (std::size_t i = 0; i < indices.size(); i += 3)
+    {
+        const auto a = indices[i] + 1;
+        const auto b = indices[i + 1] + 1;
+        const auto c = indices[i + 2] + 1;
+        append("f %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c);
+    }
+
+    output.write(buffer.data(), static_cast<std::streamsize>(used));
+    return static_cast<bool>(output);
+}
@@ -0,0 +1,34 @@
+#ifndef MESH_GENERATOR_HPP
+#define MESH_GENERATOR_HPP
+
+#include "trianglemesh.hpp"
+#include <cstdint>
+#include <string>
+
+// Procedural meshes for scaling and stress tests, fitting in the [-1, 1] cube like the bundled models
+enum class GeneratedShape
+{
+    Sphere,  // tessellated UV sphere of radius 1 with smooth normals
+    Terrain, // height field grid over the xz square with value noise heights
+    Soup     // independent equilateral triangles at random positions and orientations, with flat normals
+};
+
+struct MeshGeneratorOptions
+{
+    GeneratedShape shape{GeneratedShape::Sphere};
+    std::int64_t triangles{1000}; // target number of triangles; the sphere and the terrain round it to their grid
+    float triangle_size{0.0f}; // soup only: edge length, <= 0 sizes the triangles to cover the cube about once
+    float roughness{0.25f}; // terrain only: amplitude of the heights
+    std::uint32_t seed{1};
+};
+
+// Generate a mesh with unified vertices, uvs and normals; the sphere and the terrain have the triangle size set by the count
+TriangleMesh generate_mesh(const MeshGeneratorOptions& options, const MeshLoadOptions& load_options = MeshLoadOptions{});
+
+// Parse a shape name ("sphere", "terrain" or "soup"); returns false if unknown
+bool parse_generated_shape(const std::string& name, GeneratedShape& shape);
+
+// Write the mesh as a Wavefront .obj file readable by TriangleMesh
+bool write_obj_file(const TriangleMesh& mesh, const std::string& filename);
+
+#endif // MESH_GENERATOR_HPP
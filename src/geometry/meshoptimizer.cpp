@@ -0,0 +1,261 @@
+#include "meshoptimizer.hpp"
+#include "trianglemesh.hpp"
+#include "vector.hpp"
+#include <algorithm>
+#include <deque>
+#include <iostream>
+#include <numeric>
+
+float average_cache_miss_ratio(const std::vector<int>& indices, int cache_size)
+{
+    const auto number_triangles = indices.size() / 3;
+    if (number_triangles == 0)
+    {
+        return 0.0f;
+    }
+
+    std::deque<int> cache;
+    std::size_t misses = 0;
+    for (const auto index: indices)
+    {
+        if (std::find(cache.begin(), cache.end(), index) != cache.end())
+        {
+            continue;
+        }
+
+        ++misses;
+        cache.push_back(index);
+        if (static_cast<int>(cache.size()) > cache_size)
+        {
+            cache.pop_front();
+        }
+    }
+
+    return static_cast<float>(misses) / number_triangles;
+}
+
+std::vector<int> tipsify(const std::vector<int>& indices, int number_vertices, int cache_size, std::vector<int>& clusters)
+{
+    const int number_triangles = static_cast<int>(indices.size() / 3);
+
+    // Vertex-triangle adjacency stored as offsets into a single array
+    std::vector<int> live_triangles(number_vertices, 0);
+    for (const auto index: indices)
+    {
+        ++live_triangles[index];
+    }
+
+    std::vector<int> adjacency_offset(number_vertices + 1, 0);
+    std::partial_sum(live_triangles.begin(), live_triangles.end(), adjacency_offset.begin() + 1);
+    std::vector<int> adjacency(indices.size());
+    std::vector<int> fill_position(adjacency_offset.begin(), adjacency_offset.end() - 1);
+    for (int i = 0; i < number_triangles; ++i)
+    {
+        for (int j = 0; j < 3; ++j)
+        {
+            adjacency[fill_position[indices[3 * i + j]]++] = i;
+        }
+    }
+
+    std::vector<int> cache_time(number_vertices, 0);
+    std::vector<bool> emitted(number_triangles, false);
+    std::vector<int> dead_end_stack;
+    std::vector<int> candidates;
+    std::vector<int> order;
+    order.reserve(number_triangles);
+    clusters.clear();
+
+    int timestamp = cache_size + 1;
+    int cursor = 0;
+    int fanning_vertex = number_triangles > 0 ? indices[0] : -1;
+    bool restarted = true; // the fanning vertex is no longer in the cache, i.e. the cache was effectively flushed
+
+    while (fanning_vertex >= 0)
+    {
+        if (restarted)
+        {
+            clusters.push_back(static_cast<int>(order.size()));
+            restarted = false;
+        }
+
+        candidates.clear();
+        for (int k = adjacency_offset[fanning_vertex]; k < adjacency_offset[fanning_vertex + 1]; ++k)
+        {
+            const int triangle = adjacency[k];
+            if (emitted[triangle])
+            {
+                continue;
+            }
+
+            for (int j = 0; j < 3; ++j)
+            {
+                const int vertex = indices[3 * triangle + j];
+                dead_end_stack.push_back(vertex);
+                candidates.push_back(vertex);
+                --live_triangles[vertex];
+
+                if (timestamp - cache_time[vertex] > cache_size)
+                {
+                    cache_time[vertex] = timestamp++;
+                }
+            }
+
+            emitted[triangle] = true;
+            order.push_back(triangle);
+        }
+
+        // Choose the next fanning vertex: prefer the candidate that will stay the longest in the cache
+        int best_vertex = -1;
+        int best_priority = -1;
+        for (const auto vertex: candidates)
+        {
+            if (live_triangles[vertex] <= 0)
+            {
+                continue;
+            }
+
+            int priority = 0;
+            if (timestamp - cache_time[vertex] + 2 * live_triangles[vertex] <= cache_size)
+            {
+                priority = timestamp - cache_time[vertex];
+            }
+
+            if (priority > best_priority)
+            {
+                best_priority = priority;
+                best_vertex = vertex;
+            }
+        }
+
+        if (best_vertex < 0)
+        {
+            // Dead end: look for a recently referenced vertex with live triangles
+            while (!dead_end_stack.empty() && best_vertex < 0)
+            {
+                const int vertex = dead_end_stack.back();
+                dead_end_stack.pop_back();
+                if (live_triangles[vertex] > 0)
+                {
+                    best_vertex = vertex;
+                }
+            }
+
+            // Otherwise, continue from the next vertex in input order with live triangles
+            while (best_vertex < 0 && cursor < number_vertices)
+            {
+                if (live_triangles[cursor] > 0)
+                {
+                    best_vertex = cursor;
+                }
+                ++cursor;
+            }
+
+            restarted = best_vertex >= 0 && timestamp - cache_time[best_vertex] > cache_size;
+        }
+
+        fanning_vertex = best_vertex;
+    }
+
+    return order;
+}
+
+std::vector<int> sort_clusters_by_overdraw(const std::vector<int>& indices, const std::vector<int>& order,
+                                           const std::vector<int>& clusters, const TriangleMesh& mesh)
+{
+    const int number_clusters = static_cast<int>(clusters.size());
+
+    // Area weighted centroid of the whole mesh
+    Vector3f mesh_centroid;
+    double mesh_area = 0.0;
+    std::vector<Vector3f> cluster_centroid(number_clusters);
+    std::vector<Vector3f> cluster_normal(number_clusters);
+
+    for (int c = 0; c < number_clusters; ++c)
+    {
+        const int begin = clusters[c];
+        const int end = (c + 1 < number_clusters ? clusters[c + 1] : static_cast<int>(order.size()));
+        double cluster_area = 0.0;
+
+        for (int t = begin; t < end; ++t)
+        {
+            const int triangle = order[t];
+            const auto& vertex0 = mesh.vertex(indices[3 * triangle]);
+            const auto& vertex1 = mesh.vertex(indices[3 * triangle + 1]);
+            const auto& vertex2 = mesh.vertex(indices[3 * triangle + 2]);
+
+            const Vector3f normal = cross(vertex1 - vertex0, vertex2 - vertex0); // length is twice the triangle area
+            const double area = normal.length() / 2.0;
+            const Vector3f centroid = (vertex0 + vertex1 + vertex2) / 3.0;
+
+            cluster_normal[c] += normal;
+            cluster_centroid[c] += centroid * area;
+            cluster_area += area;
+        }
+
+        mesh_centroid += cluster_centroid[c];
+        mesh_area += cluster_area;
+
+        if (cluster_area > 0.0)
+        {
+            cluster_centroid[c] /= cluster_area;
+        }
+    }
+
+    if (mesh_area > 0.0)
+    {
+        mesh_centroid /= mesh_area;
+    }
+
+    // Clusters whose normal points away from the center tend to occlude the others
+    std::vector<float> occlusion(number_clusters);
+    for (int c = 0; c < number_clusters; ++c)
+    {
+        occlusion[c] = float(dot(cluster_centroid[c] - mesh_centroid, cluster_normal[c]));
+    }
+
+    std::vector<int> sorted_clusters(number_clusters);
+    std::iota(sorted_clusters.begin(), sorted_clusters.end(), 0);
+    std::stable_sort(sorted_clusters.begin(), sorted_clusters.end(),
+                     [&occlusion](int lhs, int rhs) { return occlusion[lhs] > occlusion[rhs]; });
+
+    std::vector<int> sorted_order;
+    sorted_order.reserve(order.size());
+    for (const auto c: sorted_clusters)
+    {
+        const int begin = clusters[c];
+        const int end = (c + 1 < number_clusters ? clusters[c + 1] : static_cast<int>(order.size()));
+        sorted_order.insert(sorted_order.end(), order.begin() + begin, order.begin() + end);
+    }
+
+    return sorted_order;
+}
+
+void optimize_face_order(TriangleMesh& mesh, int cache_size)
+{
+    std::vector<int> indices;
+    indices.reserve(3 * mesh.number_faces());
+    for (int i = 0; i < mesh.number_faces(); ++i)
+    {
+        for (const auto index: mesh.face(i))
+        {
+            indices.emplace_back(index);
+        }
+    }
+
+    const float acmr_before = average_cache_miss_ratio(indices, cache_size);
+
+    std::vector<int> clusters;
+    const auto tipsified_order = tipsify(indices, mesh.number_vertices(), cache_size, clusters);
+    const auto order = sort_clusters_by_overdraw(indices, tipsified_order, clusters, mesh);
+    mesh.reorder_faces(order);
+
+    std::vector<int> optimized_indices;
+    optimized_indices.reserve(indices.size());
+    for (const auto triangle: order)
+    {
+        optimized_indices.insert(optimized_indices.end(), indices.begin() + 3 * triangle, indices.begin() + 3 * triangle + 3);
+    }
+
+    std::cerr << "Face order optimization: " << clusters.size() << " clusters, ACMR "
+              << acmr_before << " -> " << average_cache_miss_ratio(optimized_indices, cache_size) << "\n";
+}
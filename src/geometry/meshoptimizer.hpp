@@ -0,0 +1,29 @@
+#ifndef MESH_OPTIMIZER_HPP
+#define MESH_OPTIMIZER_HPP
+
+#include <vector>
+
+class TriangleMesh;
+
+// Average cache miss ratio (transformed vertices per triangle) of a FIFO post-transform vertex cache
+float average_cache_miss_ratio(const std::vector<int>& indices, int cache_size = 16);
+
+/*
+Tipsify vertex cache ordering. Reference: Sander, Nehab and Barczak - Fast Triangle Reordering
+for Vertex Locality and Reduced Overdraw (2007).
+indices holds three vertex indices per triangle; returns the new triangle order and writes on
+clusters the position (in the new order) where each cluster of triangles starts.
+*/
+std::vector<int> tipsify(const std::vector<int>& indices, int number_vertices, int cache_size, std::vector<int>& clusters);
+
+/*
+Sort the clusters produced by tipsify such that the clusters facing away from the center of
+the mesh are drawn first, which makes early depth rejection more likely for the occluded ones.
+*/
+std::vector<int> sort_clusters_by_overdraw(const std::vector<int>& indices, const std::vector<int>& order,
+                                           const std::vector<int>& clusters, const TriangleMesh& mesh);
+
+// Reorder the faces of the mesh for vertex cache reuse followed by overdraw reduction
+void optimize_face_order(TriangleMesh& mesh, int cache_size = 16);
+
+#endif // MESH_OPTIMIZER_HPP
@@ -0,0 +1,64 @@
+#include "quantization.hpp"
+#include <algorithm>
+#include <cmath>
+
+std::uint16_t quantize_unorm16(float value, float offset, float extent)
+{
+    if (extent <= 0.0f)
+    {
+        return 0;
+    }
+
+    const float normalized = std::clamp((value - offset) / extent, 0.0f, 1.0f);
+    return static_cast<std::uint16_t>(std::lround(normalized * 65535.0f));
+}
+
+static float sign_not_zero(float value)
+{
+    return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+static std::int16_t quantize_snorm16(float value)
+{
+    return static_cast<std::int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+void encode_octahedral(Vector3f normal, std::int16_t encoded[2])
+{
+    const float norm_l1 = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (norm_l1 <= 0.0f)
+    {
+        encoded[0] = 0;
+        encoded[1] = 0;
+        return;
+    }
+
+    float x = normal.x / norm_l1;
+    float y = normal.y / norm_l1;
+    if (normal.z < 0.0f)
+    {
+        const float folded_x = (1.0f - std::abs(y)) * sign_not_zero(x);
+        const float folded_y = (1.0f - std::abs(x)) * sign_not_zero(y);
+        x = folded_x;
+        y = folded_y;
+    }
+
+    encoded[0] = quantize_snorm16(x);
+    encoded[1] = quantize_snorm16(y);
+}
+
+Vector3f decode_octahedral(const std::int16_t encoded[2])
+{
+    Vector3f normal{encoded[0] / 32767.0f, encoded[1] / 32767.0f, 0.0f};
+    normal.z = 1.0f - std::abs(normal.x) - std::abs(normal.y);
+    
+    if (normal.z < 0.0f)
+    {
+        const float unfolded_x = (1.0f - std::abs(normal.y)) * sign_not_zero(normal.x);
+        const float unfolded_y = (1.0f - std::abs(normal.x)) * sign_not_zero(normal.y);
+        normal.x = unfolded_x;
+        normal.y = unfolded_y;
+    }
+
+    return unit_vector(normal);
+}
@@ -0,0 +1,35 @@
+#ifndef QUANTIZATION_HPP
+#define QUANTIZATION_HPP
+
+#include "vector.hpp"
+#include <cstdint>
+
+/*
+Compact vertex layout used by the quantized storage mode of TriangleMesh: positions and uvs are
+quantized to 16 bits relative to the bounds of the mesh and normals are octahedral encoded.
+14 bytes per vertex, instead of 32 bytes for the Vector3f/Vector2f/Vector3f triple.
+*/
+struct QuantizedVertex
+{
+    std::uint16_t position[3];
+    std::int16_t normal[2];
+    std::uint16_t uv[2];
+};
+
+// Map value in [offset; offset + extent] to [0; 65535]
+std::uint16_t quantize_unorm16(float value, float offset, float extent);
+
+inline float dequantize_unorm16(std::uint16_t value, float offset, float extent)
+{
+    return offset + value * (extent / 65535.0f);
+}
+
+/*
+Octahedral normal encoding: project the unit vector onto the octahedron |x| + |y| + |z| = 1
+and unfold the lower hemisphere over the upper one.
+Reference: Cigolle et al. - A Survey of Efficient Representations for Independent Unit Vectors (2014)
+*/
+void encode_octahedral(Vector3f normal, std::int16_t encoded[2]);
+Vector3f decode_octahedral(const std::int16_t encoded[2]);
+
+#endif // QUANTIZATION_HPP
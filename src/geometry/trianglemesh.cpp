@@ -1,12 +1,38 @@
 #include "trianglemesh.hpp"
+#include "jobsystem.hpp"
+#include "meshoptimizer.hpp"
+#include "profiler.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <unordered_map>
+#include <utility>
 
-TriangleMesh::TriangleMesh(const std::string& filename)
+// Hash of the (position, uv, normal) indices of a face element, used to weld vertices
+struct FaceElementHash
 {
+    std::size_t operator()(const FaceElement& element) const
+    {
+        std::uint64_t hash = static_cast<std::uint32_t>(element.vertex_index);
+        hash = hash * 0x9E3779B97F4A7C15ull + static_cast<std::uint32_t>(element.texture_index);
+        hash = hash * 0x9E3779B97F4A7C15ull + static_cast<std::uint32_t>(element.normal_index);
+        return static_cast<std::size_t>(hash ^ (hash >> 32));
+    }
+};
+
+bool operator==(const FaceElement& lhs, const FaceElement& rhs)
+{
+    return lhs.vertex_index == rhs.vertex_index && lhs.texture_index == rhs.texture_index && lhs.normal_index == rhs.normal_index;
+}
+
+TriangleMesh::TriangleMesh(const std::string& filename, const MeshLoadOptions& options)
+{
+    PROFILE_STAGE(MeshLoading);
+    PROFILE_SCOPE("load_mesh " + filename);
     std::ifstream input_file{filename};
     
     if (input_file.is_open())
@@ -61,120 +87,145 @@ TriangleMesh::TriangleMesh(const std::string& filename)
                   << " Texture vertices: " << uv_coordinates_.size()
                   << " Normal vectors: " << normal_vectors_.size() << "\n";
         
-        load_model_texture(filename, "_diffuse.tga", diffuse_map_);
-        load_model_texture(filename, "_nm_tangent.tga", normal_map_);
-        load_model_texture(filename, "_spec.tga", specular_map_);
+        if (options.unify_vertices || options.quantize_vertices)
+        {
+            unify_vertices();
+        }
+
+        if (options.optimize_face_order)
+        {
+            optimize_face_order(*this);
+        }
+
+        if (options.quantize_vertices)
+        {
+            quantize_vertices();
+        }
+
+        parallel_for(options.job_system, 0, options.load_textures ? 3 : 0, 1, [this, &filename](int first, int last)
+        {
+            const std::array<std::pair<const char*, TGAImage*>, 3> textures{{
+                {"_diffuse", &diffuse_map_}, {"_nm_tangent", &normal_map_}, {"_spec", &specular_map_}}};
+            for (int i = first; i < last; ++i)
+            {
+                load_model_texture(filename, textures[i].first, *textures[i].second);
+            }
+        });
     }
 }
 
-int TriangleMesh::number_vertices() const 
+TriangleMesh::TriangleMesh(std::vector<Vector3f> positions, std::vector<Vector2f> uvs, std::vector<Vector3f> normals,
+                           std::vector<std::uint32_t> indices, const MeshLoadOptions& options):
+    vertices_{std::move(positions)}, normal_vectors_{std::move(normals)}, indices_{std::move(indices)}, uv_coordinates_{std::move(uvs)}
 {
-    return static_cast<int>(vertices_.size());
-}
+    PROFILE_STAGE(MeshLoading);
+    PROFILE_SCOPE("build_mesh");
+    assert(uv_coordinates_.size() == vertices_.size() && normal_vectors_.size() == vertices_.size() && indices_.size() % 3 == 0);
 
-int TriangleMesh::number_faces() const 
-{
-    return static_cast<int>(faces_.size());
+    if (options.optimize_face_order)
+    {
+        optimize_face_order(*this);
+    }
+
+    if (options.quantize_vertices)
+    {
+        quantize_vertices();
+    }
 }
 
-Vector3f& TriangleMesh::vertex(int id)
+int TriangleMesh::number_vertices() const 
 {
-    return vertices_[id];
+    return static_cast<int>(has_quantized_vertices() ? quantized_vertices_.size() : vertices_.size());
 }
 
-const Vector3f& TriangleMesh::vertex(int id) const
+int TriangleMesh::number_faces() const 
 {
-    return vertices_[id];
+    return static_cast<int>(has_unified_vertices() ? indices_.size() / 3 : faces_.size());
 }
 
-Vector3f& TriangleMesh::vertex(int face, int vertex_number)
+Vector3f TriangleMesh::vertex(int id) const
 {
-    const auto vertex_index = faces_[face][vertex_number].vertex_index;
-    return vertices_[vertex_index];
+    if (has_quantized_vertices())
+    {
+        const auto& position = quantized_vertices_[id].position;
+        return Vector3f{dequantize_unorm16(position[0], position_offset_.x, position_extent_.x),
+                        dequantize_unorm16(position[1], position_offset_.y, position_extent_.y),
+                        dequantize_unorm16(position[2], position_offset_.z, position_extent_.z)};
+    }
+
+    return vertices_[id];
 }
 
-const Vector3f& TriangleMesh::vertex(int face, int vertex_number) const
+Vector3f TriangleMesh::vertex(int face, int vertex_number) const
 {
-    const auto vertex_index = faces_[face][vertex_number].vertex_index;
-    return vertices_[vertex_index];
+    return vertex(vertex_index(face, vertex_number));
 }
 
-std::vector<int> TriangleMesh::face(int id) const
+std::array<int, 3> TriangleMesh::face(int id) const
 {
-    std::vector<int> faces_vertices;
-    faces_vertices.reserve(faces_[id].size());
-
-    for (const auto& face: faces_[id])
-    {
-        faces_vertices.emplace_back(face.vertex_index);
-    }
-
-    return faces_vertices;
+    return std::array<int, 3>{vertex_index(id, 0), vertex_index(id, 1), vertex_index(id, 2)};
 }
 
 std::vector<FaceElement>& TriangleMesh::face_element(int id)
 {
+    assert(!has_unified_vertices());
     return faces_[id];
 }
 
 const std::vector<FaceElement>& TriangleMesh::face_element(int id) const
 {
+    assert(!has_unified_vertices());
     return faces_[id];
 }
 
-Vector2f& TriangleMesh::uv(int face, int vertex)
+Vector2f TriangleMesh::uv(int face, int vertex) const
 {
-    const auto index = faces_[face][vertex].texture_index;
-    return uv(index);
+    return uv(texture_index(face, vertex));
 }
 
-const Vector2f& TriangleMesh::uv(int face, int vertex) const
+Vector2f TriangleMesh::uv(int index) const
 {
-    const auto index = faces_[face][vertex].texture_index;
-    return uv(index);
-}
-
-Vector2f& TriangleMesh::uv(int index)
-{
-    return uv_coordinates_[index];
-}
+    if (has_quantized_vertices())
+    {
+        const auto& uv = quantized_vertices_[index].uv;
+        return Vector2f{dequantize_unorm16(uv[0], uv_offset_.x, uv_extent_.x),
+                        dequantize_unorm16(uv[1], uv_offset_.y, uv_extent_.y)};
+    }
 
-const Vector2f& TriangleMesh::uv(int index) const
-{
     return uv_coordinates_[index];
 }
 
 TGAColor TriangleMesh::diffuse_map_at(Vector2f uv) const
 {
+    PROFILE_STAGE(TextureFetch);
     Vector2i uv_screen{static_cast<int>(uv.x * diffuse_map_.get_width()),
                        static_cast<int>(uv.y * diffuse_map_.get_height())};
     return diffuse_map_.get(uv_screen.x, uv_screen.y);
 }
 
-Vector3f& TriangleMesh::normal(int face, int vertex)
+Vector2i TriangleMesh::diffuse_map_size() const
 {
-    const auto index = faces_[face][vertex].normal_index;
-    return normal(index);
+    return Vector2i{diffuse_map_.get_width(), diffuse_map_.get_height()};
 }
 
-const Vector3f& TriangleMesh::normal(int face, int vertex) const
+Vector3f TriangleMesh::normal(int face, int vertex) const
 {
-    const auto index = faces_[face][vertex].normal_index;
-    return normal(index);
+    return normal(normal_index(face, vertex));
 }
 
-Vector3f& TriangleMesh::normal(int index)
+Vector3f TriangleMesh::normal(int index) const
 {
-    return normal_vectors_[index];
-}
+    if (has_quantized_vertices())
+    {
+        return decode_octahedral(quantized_vertices_[index].normal);
+    }
 
-const Vector3f& TriangleMesh::normal(int index) const
-{
     return normal_vectors_[index];
 }
 
 Vector3f TriangleMesh::normal_map_at(Vector2f uv) const
 {
+    PROFILE_STAGE(TextureFetch);
     const auto image_uv = cast<int>(Vector2f{uv.x * normal_map_.get_width(), uv.y * normal_map_.get_height()});
     TGAColor color = normal_map_.get(image_uv.x, image_uv.y);
 
@@ -185,11 +236,175 @@ Vector3f TriangleMesh::normal_map_at(Vector2f uv) const
 
 float TriangleMesh::specular_map_at(Vector2f uv) const
 {
+    PROFILE_STAGE(TextureFetch);
     const auto image_uv = cast<int>(Vector2f{uv.x * specular_map_.get_width(), uv.y * specular_map_.get_height()});
 
     return static_cast<float>(specular_map_.get(image_uv.x, image_uv.y)[0]);
 }
 
+void TriangleMesh::reorder_faces(const std::vector<int>& order)
+{
+    assert(static_cast<int>(order.size()) == number_faces());
+    if (has_unified_vertices())
+    {
+        std::vector<std::uint32_t> reordered_indices;
+        reordered_indices.reserve(indices_.size());
+
+        for (const auto face: order)
+        {
+            reordered_indices.insert(reordered_indices.end(), indices_.begin() + 3 * face, indices_.begin() + 3 * face + 3);
+        }
+
+        indices_ = std::move(reordered_indices);
+        return;
+    }
+
+    std::vector<std::vector<FaceElement>> reordered_faces;
+    reordered_faces.reserve(faces_.size());
+
+    for (const auto face: order)
+    {
+        reordered_faces.emplace_back(std::move(faces_[face]));
+    }
+
+    faces_ = std::move(reordered_faces);
+}
+
+bool TriangleMesh::has_unified_vertices() const
+{
+    return !indices_.empty();
+}
+
+const std::vector<std::uint32_t>& TriangleMesh::indices() const
+{
+    return indices_;
+}
+
+void TriangleMesh::unify_vertices()
+{
+    std::unordered_map<FaceElement, std::uint32_t, FaceElementHash> unified_index;
+    unified_index.reserve(vertices_.size());
+
+    std::vector<Vector3f> unified_vertices;
+    std::vector<Vector2f> unified_uvs;
+    std::vector<Vector3f> unified_normals;
+    indices_.reserve(3 * faces_.size());
+
+    for (const auto& face: faces_)
+    {
+        for (const auto& element: face)
+        {
+            const auto next_index = static_cast<std::uint32_t>(unified_vertices.size());
+            const auto [position, inserted] = unified_index.emplace(element, next_index);
+            
+            if (inserted)
+            {
+                unified_vertices.emplace_back(vertices_[element.vertex_index]);
+                unified_uvs.emplace_back(uv_coordinates_[element.texture_index]);
+                unified_normals.emplace_back(normal_vectors_[element.normal_index]);
+            }
+
+            indices_.emplace_back(position->second);
+        }
+    }
+
+    std::cerr << "Unified vertices: " << unified_vertices.size() << " (from " << vertices_.size() << " positions, "
+              << uv_coordinates_.size() << " texture vertices and " << normal_vectors_.size() << " normals)\n";
+
+    vertices_ = std::move(unified_vertices);
+    uv_coordinates_ = std::move(unified_uvs);
+    normal_vectors_ = std::move(unified_normals);
+    faces_.clear();
+    faces_.shrink_to_fit();
+}
+
+bool TriangleMesh::has_quantized_vertices() const
+{
+    return !quantized_vertices_.empty();
+}
+
+std::size_t TriangleMesh::vertex_memory_bytes() const
+{
+    return vertices_.size() * sizeof(Vector3f) + uv_coordinates_.size() * sizeof(Vector2f) 
+           + normal_vectors_.size() * sizeof(Vector3f) + quantized_vertices_.size() * sizeof(QuantizedVertex);
+}
+
+void TriangleMesh::quantize_vertices()
+{
+    if (vertices_.empty())
+    {
+        return;
+    }
+
+    // Bounds of the positions and texture coordinates
+    Vector3f min_position{vertices_.front()};
+    Vector3f max_position{vertices_.front()};
+    for (const auto& position: vertices_)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            min_position[i] = std::min(min_position[i], position[i]);
+            max_position[i] = std::max(max_position[i], position[i]);
+        }
+    }
+
+    Vector2f min_uv{uv_coordinates_.front()};
+    Vector2f max_uv{uv_coordinates_.front()};
+    for (const auto& uv: uv_coordinates_)
+    {
+        for (int i = 0; i < 2; ++i)
+        {
+            min_uv[i] = std::min(min_uv[i], uv[i]);
+            max_uv[i] = std::max(max_uv[i], uv[i]);
+        }
+    }
+
+    position_offset_ = min_position;
+    position_extent_ = max_position - min_position;
+    uv_offset_ = min_uv;
+    uv_extent_ = max_uv - min_uv;
+
+    const auto float_bytes = vertex_memory_bytes();
+    quantized_vertices_.resize(vertices_.size());
+    for (std::size_t i = 0; i < vertices_.size(); ++i)
+    {
+        auto& quantized = quantized_vertices_[i];
+        for (int j = 0; j < 3; ++j)
+        {
+            quantized.position[j] = quantize_unorm16(vertices_[i][j], position_offset_[j], position_extent_[j]);
+        }
+
+        for (int j = 0; j < 2; ++j)
+        {
+            quantized.uv[j] = quantize_unorm16(uv_coordinates_[i][j], uv_offset_[j], uv_extent_[j]);
+        }
+
+        encode_octahedral(normal_vectors_[i], quantized.normal);
+    }
+
+    vertices_ = std::vector<Vector3f>{};
+    uv_coordinates_ = std::vector<Vector2f>{};
+    normal_vectors_ = std::vector<Vector3f>{};
+
+    std::cerr << "Quantized vertices: " << float_bytes << " bytes -> " << vertex_memory_bytes() << " bytes ("
+              << sizeof(QuantizedVertex) << " bytes per vertex)\n";
+}
+
+int TriangleMesh::vertex_index(int face, int vertex_number) const
+{
+    return has_unified_vertices() ? static_cast<int>(indices_[3 * face + vertex_number]) : faces_[face][vertex_number].vertex_index;
+}
+
+int TriangleMesh::texture_index(int face, int vertex_number) const
+{
+    return has_unified_vertices() ? static_cast<int>(indices_[3 * face + vertex_number]) : faces_[face][vertex_number].texture_index;
+}
+
+int TriangleMesh::normal_index(int face, int vertex_number) const
+{
+    return has_unified_vertices() ? static_cast<int>(indices_[3 * face + vertex_number]) : faces_[face][vertex_number].normal_index;
+}
+
 void load_model_texture(std::string filename, std::string suffix, TGAImage& image)
 {
     std::size_t dot_pos = filename.find_last_of(".");
@@ -198,7 +413,21 @@ void load_model_texture(std::string filename, std::string suffix, TGAImage& imag
         return;
     }
 
-    std::string texture_file{filename.substr(0, dot_pos) + suffix};
-    std::cerr << "Texture file " << texture_file << " loading " << (image.read_tga_file(texture_file.c_str()) ? "success" : "failed") << std::endl;
-    image.flip_vertically();
+    PROFILE_SCOPE("load_texture" + suffix);
+
+    // Textures are sampled with the origin on the bottom left corner
+    bool loaded = false;
+    std::string texture_file{filename.substr(0, dot_pos) + suffix + ".qoi"};
+    if (std::ifstream{texture_file}.good())
+    {
+        loaded = image.read_qoi_file(texture_file.c_str(), true);
+    }
+    else
+    {
+        texture_file = filename.substr(0, dot_pos) + suffix + ".tga";
+        loaded = image.read_tga_file(texture_file.c_str(), true);
+    }
+
+    // A single write, since textures may be loaded concurrently
+    std::cerr << ("Texture file " + texture_file + " loading " + (loaded ? "success" : "failed") + "\n") << std::flush;
 }
\ No newline at end of file
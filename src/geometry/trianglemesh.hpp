@@ -1,8 +1,11 @@
 #ifndef TRIANGLE_MESH_HPP
 #define TRIANGLE_MESH_HPP
 
+#include "quantization.hpp"
 #include "tgaimage.h"
 #include "vector.hpp"
+#include <array>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -20,34 +23,78 @@ struct FaceElement
     FaceElement(int vertex, int texture, int normal): vertex_index{vertex}, texture_index{texture}, normal_index{normal} {}
 };
 
+// Optional processing passes applied when loading a mesh
+class JobSystem;
+
+struct MeshLoadOptions
+{
+    bool optimize_face_order{false}; // reorder faces for vertex cache reuse and reduced overdraw
+    bool unify_vertices{false}; // weld (position, uv, normal) triples into vertices shared through a single index buffer
+    bool quantize_vertices{false}; // store unified vertices in the compact QuantizedVertex format (implies unify_vertices)
+    JobSystem* job_system{nullptr}; // if set, the textures are loaded concurrently as jobs
+    bool load_textures{true}; // false skips the diffuse, normal and specular maps, e.g. to time the parser alone
+};
+
 class TriangleMesh
 {
 public:
-    explicit TriangleMesh(const std::string& filename);
+    explicit TriangleMesh(const std::string& filename, const MeshLoadOptions& options = MeshLoadOptions{});
+
+    /*
+    Mesh built from unified vertices (see has_unified_vertices), e.g. a generated one, with three indices per face.
+    Such a mesh has no textures; unify_vertices and load_textures are ignored, the other options apply.
+    */
+    TriangleMesh(std::vector<Vector3f> positions, std::vector<Vector2f> uvs, std::vector<Vector3f> normals,
+                 std::vector<std::uint32_t> indices, const MeshLoadOptions& options = MeshLoadOptions{});
     int number_vertices() const;
     int number_faces() const;
-    Vector3f& vertex(int id);
-    const Vector3f& vertex(int id) const;
-    Vector3f& vertex(int face, int vertex_number);
-    const Vector3f& vertex(int face, int vertex_number) const;
-    std::vector<int> face(int id) const;
+    // Attributes are returned by value since quantized vertices are decoded on access
+    Vector3f vertex(int id) const;
+    Vector3f vertex(int face, int vertex_number) const;
+    std::array<int, 3> face(int id) const; // vertex indices
     std::vector<FaceElement>& face_element(int id);
     const std::vector<FaceElement>& face_element(int id) const;
-    Vector2f& uv(int face, int vertex);
-    const Vector2f& uv(int face, int vertex) const;
-    Vector2f& uv(int index);
-    const Vector2f& uv(int index) const;
+    Vector2f uv(int face, int vertex) const;
+    Vector2f uv(int index) const;
     TGAColor diffuse_map_at(Vector2f uv) const;
-    Vector3f& normal(int face, int vertex);
-    const Vector3f& normal(int face, int vertex) const;
-    Vector3f& normal(int index);
-    const Vector3f& normal(int index) const;
+    Vector2i diffuse_map_size() const; // in texels, e.g. to scale uv derivatives
+    Vector3f normal(int face, int vertex) const;
+    Vector3f normal(int index) const;
     Vector3f normal_map_at(Vector2f uv) const;
     float specular_map_at(Vector2f uv) const;
+    
+    // Rearrange the faces such that the i-th face becomes the face order[i]
+    void reorder_faces(const std::vector<int>& order);
+
+    /*
+    With unified vertices, vertex, uv and normal ids all refer to the same unified vertex and
+    the faces are stored as three consecutive entries of the index buffer
+    */
+    bool has_unified_vertices() const;
+    const std::vector<std::uint32_t>& indices() const;
+    
+    bool has_quantized_vertices() const;
+    
+    // Memory used by the vertex attribute arrays
+    std::size_t vertex_memory_bytes() const;
 private:
+    void unify_vertices();
+    void quantize_vertices();
+    int vertex_index(int face, int vertex_number) const;
+    int texture_index(int face, int vertex_number) const;
+    int normal_index(int face, int vertex_number) const;
+
     std::vector<Vector3f> vertices_;
-    std::vector<std::vector<FaceElement>> faces_;
+    std::vector<std::vector<FaceElement>> faces_; // empty with unified vertices
     std::vector<Vector3f> normal_vectors_;
+    std::vector<std::uint32_t> indices_; // only used with unified vertices
+
+    // Quantized storage: replaces vertices_, normal_vectors_ and uv_coordinates_
+    std::vector<QuantizedVertex> quantized_vertices_;
+    Vector3f position_offset_;
+    Vector3f position_extent_;
+    Vector2f uv_offset_;
+    Vector2f uv_extent_;
 
     // For texture coordinates
     std::vector<Vector2f> uv_coordinates_;
@@ -56,6 +103,7 @@ private:
     TGAImage specular_map_;
 };
 
+// Load the texture <model name><suffix>.qoi if it exists, otherwise <model name><suffix>.tga
 void load_model_texture(std::string filename, std::string suffix, TGAImage& image);
 
 #endif // TRIANGLE_MESH_HPP
\ No newline at end of file
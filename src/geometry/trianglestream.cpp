@@ -0,0 +1,177 @@
+#include "trianglestream.hpp"
+#include "trianglemesh.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+static const char stream_magic[8] = {'T', 'R', 'I', 'S', 'T', 'R', 'M', '\0'};
+static const std::uint32_t stream_version = 1;
+
+bool write_triangle_stream(const TriangleMesh& mesh, const std::string& filename)
+{
+    std::ofstream output{filename, std::ios::binary};
+    if (!output.is_open())
+    {
+        std::cerr << "can't open file " << filename << "\n";
+        return false;
+    }
+
+    TriangleStreamHeader header{};
+    std::memcpy(header.magic, stream_magic, sizeof(stream_magic));
+    header.version = stream_version;
+    header.record_size = sizeof(StreamedTriangle);
+    header.number_triangles = static_cast<std::uint64_t>(mesh.number_faces());
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (int i = 0; i < mesh.number_faces(); ++i)
+    {
+        StreamedTriangle triangle;
+        for (int j = 0; j < 3; ++j)
+        {
+            const auto position = mesh.vertex(i, j);
+            const auto uv = mesh.uv(i, j);
+            const auto normal = mesh.normal(i, j);
+            
+            for (int k = 0; k < 3; ++k)
+            {
+                triangle.position[j][k] = position[k];
+                triangle.normal[j][k] = normal[k];
+            }
+
+            triangle.uv[j][0] = uv.x;
+            triangle.uv[j][1] = uv.y;
+        }
+
+        output.write(reinterpret_cast<const char*>(&triangle), sizeof(triangle));
+    }
+
+    return output.good();
+}
+
+TriangleStream::TriangleStream(const std::string& filename, int batch_size, int number_buffers):
+    input_{filename, std::ios::binary}, batch_size_{std::max(1, batch_size)}, buffers_(std::max(2, number_buffers))
+{
+    if (!input_.is_open())
+    {
+        std::cerr << "can't open file " << filename << "\n";
+        return;
+    }
+
+    input_.read(reinterpret_cast<char*>(&header_), sizeof(header_));
+    if (!input_.good() || std::memcmp(header_.magic, stream_magic, sizeof(stream_magic)) != 0 
+        || header_.version != stream_version || header_.record_size != sizeof(StreamedTriangle))
+    {
+        std::cerr << "invalid triangle stream " << filename << "\n";
+        input_.close();
+        return;
+    }
+
+    for (auto& buffer: buffers_)
+    {
+        buffer.reserve(batch_size_);
+    }
+
+    prefetch_thread_ = std::thread{&TriangleStream::prefetch, this};
+}
+
+TriangleStream::~TriangleStream()
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        stopping_ = true;
+    }
+    
+    buffer_released_.notify_all();
+    if (prefetch_thread_.joinable())
+    {
+        prefetch_thread_.join();
+    }
+}
+
+bool TriangleStream::is_open() const
+{
+    return input_.is_open();
+}
+
+std::uint64_t TriangleStream::number_triangles() const
+{
+    return header_.number_triangles;
+}
+
+const std::vector<StreamedTriangle>* TriangleStream::acquire_batch()
+{
+    if (!is_open())
+    {
+        return nullptr;
+    }
+
+    std::unique_lock<std::mutex> lock{mutex_};
+    buffer_filled_.wait(lock, [this]() { return filled_ > 0 || finished_; });
+    
+    if (filled_ == 0)
+    {
+        return nullptr;
+    }
+
+    return &buffers_[read_position_];
+}
+
+void TriangleStream::release_batch()
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        read_position_ = (read_position_ + 1) % static_cast<int>(buffers_.size());
+        --filled_;
+    }
+
+    buffer_released_.notify_one();
+}
+
+void TriangleStream::prefetch()
+{
+    std::uint64_t remaining = header_.number_triangles;
+    
+    while (remaining > 0)
+    {
+        int position;
+        {
+            std::unique_lock<std::mutex> lock{mutex_};
+            buffer_released_.wait(lock, [this]() { return filled_ < static_cast<int>(buffers_.size()) || stopping_; });
+            
+            if (stopping_)
+            {
+                return;
+            }
+
+            position = write_position_;
+        }
+
+        // The buffer at write_position_ is not visible to the consumer, so it is filled without the lock
+        auto& buffer = buffers_[position];
+        const auto count = static_cast<std::size_t>(std::min<std::uint64_t>(remaining, batch_size_));
+        buffer.resize(count);
+        input_.read(reinterpret_cast<char*>(buffer.data()), count * sizeof(StreamedTriangle));
+        
+        if (!input_.good())
+        {
+            std::cerr << "an error occured while reading the triangle stream\n";
+            break;
+        }
+
+        remaining -= count;
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            write_position_ = (write_position_ + 1) % static_cast<int>(buffers_.size());
+            ++filled_;
+        }
+        
+        buffer_filled_.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        finished_ = true;
+    }
+    
+    buffer_filled_.notify_all();
+}
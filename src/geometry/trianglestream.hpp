@@ -0,0 +1,74 @@
+#ifndef TRIANGLE_STREAM_HPP
+#define TRIANGLE_STREAM_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class TriangleMesh;
+
+/*
+Preprocessed on-disk format for out-of-core rendering: a header followed by self-contained
+triangle records, so that any batch of triangles can be rendered without the rest of the mesh.
+*/
+struct TriangleStreamHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t record_size;
+    std::uint64_t number_triangles;
+};
+
+struct StreamedTriangle
+{
+    float position[3][3];
+    float uv[3][2];
+    float normal[3][3];
+};
+
+// Convert a mesh to the streaming format
+bool write_triangle_stream(const TriangleMesh& mesh, const std::string& filename);
+
+/*
+Reads a triangle stream in batches through a bounded ring of buffers. A background thread
+prefetches the next batches while the consumer renders the current one.
+*/
+class TriangleStream
+{
+public:
+    explicit TriangleStream(const std::string& filename, int batch_size = 16384, int number_buffers = 3);
+    ~TriangleStream();
+    TriangleStream(const TriangleStream&) = delete;
+    TriangleStream& operator=(const TriangleStream&) = delete;
+
+    bool is_open() const;
+    std::uint64_t number_triangles() const;
+
+    // Blocks until the next batch is available; returns nullptr once the stream is exhausted
+    const std::vector<StreamedTriangle>* acquire_batch();
+
+    // Return the batch given by the last acquire_batch to the ring so it can be refilled
+    void release_batch();
+private:
+    void prefetch();
+
+    std::ifstream input_;
+    TriangleStreamHeader header_{};
+    int batch_size_;
+    std::vector<std::vector<StreamedTriangle>> buffers_;
+    int filled_{0}; // number of buffers ready to be consumed
+    int read_position_{0};
+    int write_position_{0};
+    bool finished_{false};
+    bool stopping_{false};
+    std::mutex mutex_;
+    std::condition_variable buffer_filled_;
+    std::condition_variable buffer_released_;
+    std::thread prefetch_thread_;
+};
+
+#endif // TRIANGLE_STREAM_HPP
@@ -0,0 +1,474 @@
+#include "jobsystem.hpp"
+#include <algorithm>
+#include <chrono>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+struct Job
+{
+    std::function<void()> function;
+    JobCounter* counter;
+    bool pinned;
+    Job* next; // link on the lock-free stack of pinned jobs
+};
+
+static thread_local const JobSystem* current_job_system = nullptr;
+static thread_local int current_worker = -1;
+static thread_local int job_depth = 0; // jobs running on the calling thread, nested through wait
+static thread_local char thread_token; // its address identifies the calling thread
+static thread_local const JobSystem* injection_job_system = nullptr; // job system of the last injection queue claimed
+static thread_local int injection_slot = -1;
+
+// Push the list first ... last on a lock-free stack
+static void push_jobs(std::atomic<Job*>& stack, Job* first, Job* last)
+{
+    Job* head = stack.load(std::memory_order_relaxed);
+    do
+    {
+        last->next = head;
+    } while (!stack.compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+}
+
+// Take every job of a lock-free stack, oldest first
+static Job* take_jobs(std::atomic<Job*>& stack)
+{
+    Job* job = stack.exchange(nullptr, std::memory_order_acquire);
+    Job* reversed = nullptr;
+    while (job != nullptr)
+    {
+        Job* next = job->next;
+        job->next = reversed;
+        reversed = job;
+        job = next;
+    }
+
+    return reversed;
+}
+
+bool JobCounter::done() const
+{
+    return pending_.load(std::memory_order_acquire) == 0;
+}
+
+WorkStealingDeque::WorkStealingDeque(int capacity)
+{
+    std::int64_t size = 1;
+    while (size < capacity)
+    {
+        size *= 2;
+    }
+
+    mask_ = size - 1;
+    buffer_ = std::make_unique<std::atomic<Job*>[]>(size);
+}
+
+bool WorkStealingDeque::push(Job* job)
+{
+    const std::int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    const std::int64_t top = top_.load(std::memory_order_acquire);
+    if (bottom - top > mask_)
+    {
+        return false;
+    }
+
+    buffer_[bottom & mask_].store(job, std::memory_order_relaxed);
+    bottom_.store(bottom + 1, std::memory_order_release);
+    return true;
+}
+
+Job* WorkStealingDeque::pop()
+{
+    // The sequentially consistent store and load order the reservation of the bottom slot against thieves
+    const std::int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(bottom, std::memory_order_seq_cst);
+    std::int64_t top = top_.load(std::memory_order_seq_cst);
+
+    if (top > bottom)
+    {
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job* job = buffer_[bottom & mask_].load(std::memory_order_relaxed);
+    if (top == bottom)
+    {
+        // Last job: race against the thieves for it
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            job = nullptr;
+        }
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    return job;
+}
+
+Job* WorkStealingDeque::steal()
+{
+    std::int64_t top = top_.load(std::memory_order_seq_cst);
+    const std::int64_t bottom = bottom_.load(std::memory_order_seq_cst);
+    if (top >= bottom)
+    {
+        return nullptr;
+    }
+
+    Job* job = buffer_[top & mask_].load(std::memory_order_relaxed);
+    if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+    {
+        return nullptr;
+    }
+
+    return job;
+}
+
+bool WorkStealingDeque::empty() const
+{
+    return top_.load(std::memory_order_acquire) >= bottom_.load(std::memory_order_relaxed);
+}
+
+JobSystem::JobSystem(int number_threads, bool pin_threads)
+{
+    if (number_threads <= 0)
+    {
+        number_threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+
+    for (int i = 0; i < number_threads; ++i)
+    {
+        workers_.emplace_back(std::make_unique<Worker>());
+    }
+
+    for (int i = 0; i < number_threads; ++i)
+    {
+        threads_.emplace_back(&JobSystem::work, this, i);
+#ifdef __linux__
+        if (pin_threads)
+        {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(i % std::max(1u, std::thread::hardware_concurrency()), &cpus);
+            pthread_setaffinity_np(threads_.back().native_handle(), sizeof(cpus), &cpus);
+        }
+#else
+        (void)pin_threads;
+#endif
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    stopping_.store(true);
+    wake_workers(true);
+    for (auto& thread: threads_)
+    {
+        thread.join();
+    }
+
+    for (auto& queue: injection_queues_)
+    {
+        delete queue.jobs.load();
+    }
+}
+
+int JobSystem::number_threads() const
+{
+    return static_cast<int>(workers_.size());
+}
+
+int JobSystem::current_thread_index() const
+{
+    return current_job_system == this ? current_worker : -1;
+}
+
+bool JobSystem::running_job()
+{
+    return job_depth > 0;
+}
+
+void JobSystem::submit(std::function<void()> function, JobCounter* counter, int affinity)
+{
+    const int thread_index = current_thread_index();
+    Job* job = new Job{std::move(function), counter, affinity >= 0, nullptr};
+    if (counter != nullptr)
+    {
+        counter->pending_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (affinity >= 0)
+    {
+        // Counted apart from queued_, so that the other workers can go to sleep while it waits for its worker
+        auto& worker = *workers_[affinity % workers_.size()];
+        worker.pinned_queued.fetch_add(1);
+        push_jobs(worker.pinned_jobs, job, job);
+        wake_workers(true); // only one of the workers can run it
+        return;
+    }
+
+    queued_.fetch_add(1);
+    if (thread_index >= 0)
+    {
+        if (!workers_[thread_index]->deque.push(job))
+        {
+            // The deque is full: run the job right away
+            queued_.fetch_sub(1);
+            execute(job);
+            return;
+        }
+        wake_workers(false);
+    }
+    else
+    {
+        WorkStealingDeque* jobs = injection_queue(true);
+        if (jobs == nullptr || !jobs->push(job))
+        {
+            // Every injection queue is in use, or this one is full: run the job right away
+            queued_.fetch_sub(1);
+            execute(job);
+            return;
+        }
+        wake_workers(false);
+    }
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+    const int thread_index = current_thread_index();
+    while (!counter.done())
+    {
+        Job* job = find_job(thread_index);
+        if (job != nullptr)
+        {
+            execute(job);
+            continue;
+        }
+
+        // Nothing to run here: the remaining jobs are running on other threads or pinned to other workers
+        std::unique_lock<std::mutex> lock{sleep_mutex_};
+        counter_done_.wait_for(lock, std::chrono::milliseconds{1}, [&counter]() { return counter.done(); });
+    }
+
+    if (thread_index < 0)
+    {
+        release_injection_queue();
+    }
+}
+
+WorkStealingDeque* JobSystem::injection_queue(bool create)
+{
+    // Only the calling thread stores its token in a queue, or replaces it with nullptr
+    if (injection_job_system == this && injection_slot >= 0 &&
+        injection_queues_[injection_slot].owner.load(std::memory_order_relaxed) == &thread_token)
+    {
+        return injection_queues_[injection_slot].jobs.load(std::memory_order_relaxed);
+    }
+    // A thread alternating between job systems finds its queue again
+    const int used = injection_queues_used_.load(std::memory_order_acquire);
+    for (int i = 0; i < used; ++i)
+    {
+        if (injection_queues_[i].owner.load(std::memory_order_relaxed) == &thread_token)
+        {
+            injection_job_system = this;
+            injection_slot = i;
+            return injection_queues_[i].jobs.load(std::memory_order_relaxed);
+        }
+    }
+    if (!create)
+    {
+        return nullptr;
+    }
+
+    for (int i = 0; i < max_injection_queues; ++i)
+    {
+        auto& queue = injection_queues_[i];
+        const void* free_queue = nullptr;
+        if (queue.owner.compare_exchange_strong(free_queue, &thread_token, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+            WorkStealingDeque* jobs = queue.jobs.load(std::memory_order_relaxed);
+            if (jobs == nullptr)
+            {
+                jobs = new WorkStealingDeque{1024};
+                queue.jobs.store(jobs, std::memory_order_release);
+            }
+
+            int used = injection_queues_used_.load(std::memory_order_relaxed);
+            while (used <= i && !injection_queues_used_.compare_exchange_weak(used, i + 1, std::memory_order_release))
+            {}
+
+            injection_job_system = this;
+            injection_slot = i;
+            return jobs;
+        }
+    }
+
+    return nullptr;
+}
+
+void JobSystem::release_injection_queue()
+{
+    // The workers may still steal from the queue: it is only handed to another thread once empty
+    WorkStealingDeque* jobs = injection_queue(false);
+    if (jobs != nullptr && jobs->empty())
+    {
+        injection_queues_[injection_slot].owner.store(nullptr, std::memory_order_release);
+    }
+}
+
+// Oldest job of an injection queue, starting from a different queue on each worker
+Job* JobSystem::take_injected_job(int thread_index)
+{
+    const int used = injection_queues_used_.load(std::memory_order_acquire);
+    for (int k = 0; k < used; ++k)
+    {
+        WorkStealingDeque* jobs = injection_queues_[(thread_index + k) % used].jobs.load(std::memory_order_acquire);
+        Job* job = jobs != nullptr ? jobs->steal() : nullptr;
+        if (job != nullptr)
+        {
+            return job;
+        }
+    }
+
+    return nullptr;
+}
+
+Job* JobSystem::find_job(int thread_index)
+{
+    Job* job = nullptr;
+    const int number_workers = static_cast<int>(workers_.size());
+
+    if (thread_index >= 0)
+    {
+        auto& worker = *workers_[thread_index];
+
+        // Jobs pinned to this worker first, oldest first
+        for (Job* pinned = take_jobs(worker.pinned_jobs); pinned != nullptr; pinned = pinned->next)
+        {
+            worker.local_jobs.push_back(pinned);
+        }
+        if (!worker.local_jobs.empty())
+        {
+            job = worker.local_jobs.front();
+            worker.local_jobs.pop_front();
+        }
+
+        if (job == nullptr)
+        {
+            job = worker.deque.pop();
+        }
+
+        // Then the oldest job submitted from outside, and finally steal the oldest job of another worker
+        if (job == nullptr)
+        {
+            job = take_injected_job(thread_index);
+        }
+
+        for (int k = 1; job == nullptr && k < number_workers; ++k)
+        {
+            job = workers_[(thread_index + k) % number_workers]->deque.steal();
+        }
+    }
+    else
+    {
+        /*
+        A thread outside of the system only runs the jobs it submitted: a job taken by the writer thread
+        of a FrameWriter, say, could wait on that thread and stall every frame
+        */
+        WorkStealingDeque* jobs = injection_queue(false);
+        job = jobs != nullptr ? jobs->steal() : nullptr;
+    }
+
+    if (job != nullptr)
+    {
+        (job->pinned ? workers_[thread_index]->pinned_queued : queued_).fetch_sub(1);
+    }
+
+    return job;
+}
+
+void JobSystem::execute(Job* job)
+{
+    ++job_depth;
+    job->function();
+    --job_depth;
+
+    JobCounter* counter = job->counter;
+    delete job;
+    if (counter != nullptr && counter->pending_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        std::lock_guard<std::mutex> lock{sleep_mutex_};
+        counter_done_.notify_all();
+    }
+}
+
+void JobSystem::wake_workers(bool all)
+{
+    if (sleeping_.load() == 0)
+    {
+        return;
+    }
+
+    // Taking the mutex orders the notification after a worker that checked queued_ started waiting
+    std::lock_guard<std::mutex> lock{sleep_mutex_};
+    if (all)
+    {
+        work_available_.notify_all();
+    }
+    else
+    {
+        work_available_.notify_one();
+    }
+}
+
+void JobSystem::work(int thread_index)
+{
+    current_job_system = this;
+    current_worker = thread_index;
+    while (true)
+    {
+        Job* job = find_job(thread_index);
+        if (job != nullptr)
+        {
+            execute(job);
+            continue;
+        }
+
+        // Jobs pinned to other workers do not keep this one awake
+        auto& worker = *workers_[thread_index];
+        sleeping_.fetch_add(1);
+        {
+            std::unique_lock<std::mutex> lock{sleep_mutex_};
+            if (stopping_.load() && queued_.load() == 0 && worker.pinned_queued.load() == 0)
+            {
+                sleeping_.fetch_sub(1);
+                return;
+            }
+            work_available_.wait(lock, [this, &worker]()
+            {
+                return queued_.load() > 0 || worker.pinned_queued.load() > 0 || stopping_.load();
+            });
+        }
+        sleeping_.fetch_sub(1);
+    }
+}
+
+void parallel_for(JobSystem* job_system, int begin, int end, int grain_size, const std::function<void(int, int)>& body)
+{
+    grain_size = std::max(1, grain_size);
+    if (job_system == nullptr || end - begin <= grain_size)
+    {
+        if (begin < end)
+        {
+            body(begin, end);
+        }
+        return;
+    }
+
+    JobCounter counter;
+    for (int first = begin; first < end; first += grain_size)
+    {
+        const int last = std::min(end, first + grain_size);
+        job_system->submit([&body, first, last]() { body(first, last); }, &counter);
+    }
+    job_system->wait(counter);
+}
@@ -0,0 +1,139 @@
+#ifndef JOB_SYSTEM_HPP
+#define JOB_SYSTEM_HPP
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct Job;
+
+/*
+Number of unfinished jobs of a group, e.g. the children of a job. Submitting a job with a counter
+increments it and finishing the job decrements it; JobSystem::wait blocks on it. A counter must
+outlive the jobs that reference it.
+*/
+class JobCounter
+{
+public:
+    bool done() const;
+private:
+    friend class JobSystem;
+    std::atomic<int> pending_{0};
+};
+
+/*
+Lock-free bounded work-stealing deque of Chase and Lev. Reference: Le, Pop, Cohen and Zappa Nardelli -
+Correct and Efficient Work-Stealing for Weak Memory Models (2013). The owner thread pushes and pops
+at the bottom; any thread steals from the top, so pushing and stealing alone make a FIFO queue.
+*/
+class WorkStealingDeque
+{
+public:
+    explicit WorkStealingDeque(int capacity = 4096); // capacity is rounded up to a power of two
+
+    // Owner only; returns false if the deque is full
+    bool push(Job* job);
+
+    // Owner only; newest job, or nullptr if empty
+    Job* pop();
+
+    // Any thread; oldest job, or nullptr if empty or the race for it was lost
+    Job* steal();
+
+    // Owner only; the deque stays empty until the owner pushes again
+    bool empty() const;
+private:
+    std::atomic<std::int64_t> top_{0};
+    std::atomic<std::int64_t> bottom_{0};
+    std::int64_t mask_;
+    std::unique_ptr<std::atomic<Job*>[]> buffer_;
+};
+
+/*
+Work-stealing job system shared by the stages of the renderer, so stages running at the same time
+share one set of threads instead of oversubscribing the cores.
+- Each worker owns a WorkStealingDeque: jobs submitted from a job go to the deque of its worker and
+  run newest first, while idle workers steal the oldest jobs of the others.
+- Jobs submitted from outside of the system go to a FIFO injection queue of the submitting thread
+  (a WorkStealingDeque it pushes to), taken oldest first by the workers and by that thread while it
+  waits. A thread keeps its queue until a wait leaves it empty.
+- A job submitted with an affinity only runs on that worker, e.g. to keep thread-local state.
+- wait runs other jobs while the counter is not zero, so jobs can wait for their children.
+*/
+class JobSystem
+{
+public:
+    // number_threads <= 0 uses one worker per hardware thread; pin_threads binds worker i to CPU i (Linux only)
+    explicit JobSystem(int number_threads = 0, bool pin_threads = false);
+    ~JobSystem(); // runs the remaining jobs before joining the workers
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    int number_threads() const;
+
+    // affinity >= 0 restricts the job to the worker with that index (modulo the number of workers)
+    void submit(std::function<void()> function, JobCounter* counter = nullptr, int affinity = -1);
+
+    // Run jobs on the calling thread until the counter reaches zero
+    void wait(JobCounter& counter);
+
+    // Index of the worker of this job system running the calling thread, or -1
+    int current_thread_index() const;
+
+    /*
+    True if the calling thread is running a job of any job system. A job must not block on anything
+    but wait: the jobs below it on its thread cannot run until it returns.
+    */
+    static bool running_job();
+private:
+    struct Worker
+    {
+        WorkStealingDeque deque;
+        std::atomic<Job*> pinned_jobs{nullptr}; // lock-free stack of the jobs with affinity for this worker
+        std::deque<Job*> local_jobs; // pinned jobs taken from the stack, owner only
+        std::atomic<int> pinned_queued{0}; // pinned jobs submitted and not started yet
+    };
+
+    // Injection queue of a thread outside of the system
+    struct InjectionQueue
+    {
+        std::atomic<const void*> owner{nullptr}; // thread using the queue, nullptr if free
+        std::atomic<WorkStealingDeque*> jobs{nullptr}; // created by its first owner, kept for the next ones
+    };
+    static constexpr int max_injection_queues = 64;
+
+    // Queue of the calling thread; claimed if create, nullptr if none (or all are in use)
+    WorkStealingDeque* injection_queue(bool create);
+    void release_injection_queue();
+    Job* take_injected_job(int thread_index);
+    Job* find_job(int thread_index);
+    void execute(Job* job);
+    void wake_workers(bool all);
+    void work(int thread_index);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+    std::array<InjectionQueue, max_injection_queues> injection_queues_;
+    std::atomic<int> injection_queues_used_{0}; // queues below this index have been claimed at least once
+    std::atomic<int> queued_{0}; // jobs any worker can run, submitted and not started yet (pinned ones excluded)
+    std::atomic<int> sleeping_{0};
+    std::atomic<bool> stopping_{false};
+    std::mutex sleep_mutex_; // only used to put idle threads to sleep
+    std::condition_variable work_available_;
+    std::condition_variable counter_done_;
+};
+
+/*
+Run body(first, last) over [begin, end) split into ranges of at most grain_size elements, as jobs of
+job_system (or on the calling thread if job_system is nullptr or the range is small), and wait for them
+*/
+void parallel_for(JobSystem* job_system, int begin, int end, int grain_size, const std::function<void(int, int)>& body);
+
+#endif // JOB_SYSTEM_HPP
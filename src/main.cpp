@@ -1,26 +1,135 @@
 #include "scenes.hpp"
+#include "renderscheduler.hpp"
+#include "jobsystem.hpp"
+#include "profiler.hpp"
+#include "trianglestream.hpp"
+#include <iostream>
+
+// Write the profile report and the Chrome trace requested on the command line; false if a write failed
+static bool write_profile(const std::string& profile_output, const std::string& trace_output)
+{
+    if ((!profile_output.empty() || !trace_output.empty()) && !profiling_enabled())
+    {
+        std::cerr << "Profiling is disabled, configure with -DTINY_RENDERER_PROFILING=ON to record the stages\n";
+    }
+
+    const bool profile_written = profile_output.empty() || write_profile_json(profile_output);
+    const bool trace_written = trace_output.empty() || write_chrome_trace(trace_output);
+    return profile_written && trace_written;
+}
 
 int main(int argc, char* argv[])
 {
     std::string filename{"obj/african_head/african_head.obj"};
-    if (argc == 2)
+    std::string stream_output;
+    std::string profile_output;
+    std::string trace_output;
+    int tiled_width = 0;
+    int tiled_height = 0;
+    int orbit_views = 0;
+    bool pipelined = false;
+    bool heatmaps = false;
+    MeshLoadOptions mesh_options;
+    ImageFormat output_format{ImageFormat::TGA};
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string argument{argv[i]};
+        if (argument == "--write-stream" && i + 1 < argc)
+        {
+            stream_output = argv[++i];
+        }
+        else if (argument == "--tiled" && i + 2 < argc)
+        {
+            tiled_width = std::stoi(argv[++i]);
+            tiled_height = std::stoi(argv[++i]);
+        }
+        else if (argument == "--views" && i + 1 < argc)
+        {
+            orbit_views = std::stoi(argv[++i]);
+        }
+        else if (argument == "--qoi")
+        {
+            output_format = ImageFormat::QOI;
+        }
+        else if (argument == "--profile" && i + 1 < argc)
+        {
+            profile_output = argv[++i];
+        }
+        else if (argument == "--trace" && i + 1 < argc)
+        {
+            trace_output = argv[++i];
+        }
+        else if (argument == "--pipeline")
+        {
+            pipelined = true;
+        }
+        else if (argument == "--heatmaps")
+        {
+            heatmaps = true;
+        }
+        else if (argument == "--optimize-faces")
+        {
+            mesh_options.optimize_face_order = true;
+        }
+        else if (argument == "--unify-vertices")
+        {
+            mesh_options.unify_vertices = true;
+        }
+        else if (argument == "--quantize-vertices")
+        {
+            mesh_options.quantize_vertices = true;
+        }
+        else
+        {
+            filename = argument;
+        }
+    }
+
+    // Preprocessed triangle streams are rendered out-of-core
+    if (filename.size() > 4 && filename.compare(filename.size() - 4, 4, ".trs") == 0)
+    {
+        draw_streamed_gouraud_shading(filename, output_format);
+        return write_profile(profile_output, trace_output) ? 0 : 1;
+    }
+
+    if (!stream_output.empty())
+    {
+        return write_triangle_stream(TriangleMesh{filename, mesh_options}, stream_output) ? 0 : 1;
+    }
+
+    // One job system shared by every stage, declared first so it outlives the scenes and their frame writer
+    JobSystem job_system;
+    mesh_options.job_system = &job_system;
+    Scenes scenes{filename, mesh_options, 600, 600, &job_system};
+    scenes.set_output_format(output_format);
+    scenes.set_pipelined(pipelined);
+    scenes.set_heatmaps(heatmaps);
+    if (tiled_width > 0 && tiled_height > 0)
+    {
+        scenes.draw_our_gl_tiled(ShadersOptions::Gouraud, tiled_width, tiled_height);
+        scenes.draw_our_gl_tiled(ShadersOptions::BasicTexture, tiled_width, tiled_height);
+        scenes.draw_our_gl_tiled(ShadersOptions::NormalMappingTexture, tiled_width, tiled_height);
+        scenes.draw_our_gl_tiled(ShadersOptions::Phong, tiled_width, tiled_height);
+        return write_profile(profile_output, trace_output) ? 0 : 1;
+    }
+
+    // The scenes are independent jobs, each one drawing into a render context borrowed from the scheduler
+    RenderScheduler scheduler{job_system, 600, 600};
+    scheduler.submit([&scenes](RenderContext& context) { scenes.draw_wire_mesh(context); });
+    scheduler.submit([&scenes](RenderContext& context) { scenes.draw_random_colored_triangles(context); });
+    scheduler.submit([&scenes](RenderContext& context) { scenes.draw_back_face_culling(context); });
+    scheduler.submit([&scenes](RenderContext& context) { scenes.draw_depth_buffer(context); });
+    scheduler.submit([&scenes](RenderContext& context) { scenes.draw_textured_depth_buffer(context); });
+    scheduler.submit([&scenes](RenderContext& context) { scenes.draw_perspective_projection(context); });
+    scheduler.submit([&scenes](RenderContext& context) { scenes.draw_gouraud_shading(context); });
+    scheduler.submit([&scenes](RenderContext& context) { scenes.draw_look_at(context); });
+    for (const auto shader: {ShadersOptions::Gouraud, ShadersOptions::BasicTexture, ShadersOptions::NormalMappingTexture, ShadersOptions::Phong})
     {
-        filename = argv[1];
+        scheduler.submit([&scenes, shader](RenderContext& context) { scenes.draw_our_gl(context, shader); });
     }
+    scenes.draw_our_gl_orbit(scheduler, ShadersOptions::Phong, orbit_views);
+    scheduler.wait();
 
-    Scenes scenes{filename};
-    scenes.draw_wire_mesh();
-    scenes.draw_random_colored_triangles();
-    scenes.draw_back_face_culling();
-    scenes.draw_depth_buffer();
-    scenes.draw_textured_depth_buffer();
-    scenes.draw_perspective_projection();
-    scenes.draw_gouraud_shading();
-    scenes.draw_look_at();
-    scenes.draw_our_gl(ShadersOptions::Gouraud);
-    scenes.draw_our_gl(ShadersOptions::BasicTexture);
-    scenes.draw_our_gl(ShadersOptions::NormalMappingTexture);
-    scenes.draw_our_gl(ShadersOptions::Phong);
-
-    return 0;
-}
\ No newline at end of file
+    const bool written = scenes.wait_for_output();
+    return write_profile(profile_output, trace_output) && written ? 0 : 1;
+}
@@ -1,16 +1,29 @@
 #include "matrix.hpp"
+#include <algorithm>
 #include <cassert>
-#include <exception>
+#include <stdexcept>
 
 Matrix::Matrix() {}
 
 Matrix::Matrix(int number_rows, int number_columns): 
-    data{std::vector<std::vector<float>>(number_rows, std::vector<float>(number_columns, 0.0f))}, rows{number_rows}, columns{number_columns}
-{}
+    rows{number_rows}, columns{number_columns}
+{
+    if (rows > max_size || columns > max_size)
+    {
+        throw std::logic_error("Matrix supports up to 4x4 elements\n");
+    }
+}
 
-Matrix::Matrix(std::vector<std::vector<float>>&& initializer): 
-    data{initializer}, rows{static_cast<int>(data.size())}, columns{static_cast<int>(data.back().size())}
-{}
+Matrix::Matrix(std::initializer_list<std::initializer_list<float>> initializer): 
+    Matrix{static_cast<int>(initializer.size()), static_cast<int>(initializer.begin()->size())}
+{
+    int i = 0;
+    for (const auto& row: initializer)
+    {
+        assert(static_cast<int>(row.size()) == columns);
+        std::copy(row.begin(), row.end(), (*this)[i++]);
+    }
+}
 
 int Matrix::number_rows() const
 {
@@ -22,21 +35,21 @@ int Matrix::number_columns() const
     return columns;
 }
 
-std::vector<float>& Matrix::operator[](int i)
+float* Matrix::operator[](int i)
 {
-    return data[i];
+    return data.data() + i * max_size;
 }
 
-const std::vector<float>& Matrix::operator[](int i) const
+const float* Matrix::operator[](int i) const
 {
-    return data[i];
+    return data.data() + i * max_size;
 }
 
 void Matrix::fill_row(int row, Vector3f vector)
 {
     for (int j = 0; j < columns; ++j)
     {
-        data[row][j] = vector[j];
+        (*this)[row][j] = vector[j];
     }
 }
 
@@ -44,7 +57,7 @@ void Matrix::fill_row(int row, Vector2f vector)
 {
     for (int j = 0; j < columns; ++j)
     {
-        data[row][j] = vector[j];
+        (*this)[row][j] = vector[j];
     }
 }
 
@@ -52,7 +65,7 @@ void Matrix::fill_column(int column, Vector3f vector)
 {
     for (int i = 0; i < rows; ++i)
     {
-        data[i][column] = vector[i];
+        (*this)[i][column] = vector[i];
     }
 }
 
@@ -60,7 +73,7 @@ void Matrix::fill_column(int column, Vector2f vector)
 {
     for (int i = 0; i < rows; ++i)
     {
-        data[i][column] = vector[i];
+        (*this)[i][column] = vector[i];
     }
 }
 
@@ -73,7 +86,7 @@ bool operator==(const Matrix& lhs, const Matrix& rhs)
 
     for (int i = 0; i < lhs.number_rows(); ++i)
     {
-        if (lhs[i] != rhs[i])
+        if (!std::equal(lhs[i], lhs[i] + lhs.number_columns(), rhs[i]))
         {
             return false;
         }
@@ -2,25 +2,29 @@
 #define MATRIX_HPP
 
 #include "vector.hpp"
+#include <array>
+#include <initializer_list>
 #include <iostream>
-#include <vector>
 
+// Matrix of up to 4 x 4 floats, stored inline so the transforms of the shaders do not allocate
 class Matrix
 {
 public:
+    static constexpr int max_size = 4;
+
     Matrix();
     Matrix(int number_rows, int number_columns);
-    explicit Matrix(std::vector<std::vector<float>>&& initializer);
+    explicit Matrix(std::initializer_list<std::initializer_list<float>> initializer);
     inline int number_rows() const;
     inline int number_columns() const;
-    std::vector<float>& operator[](int i);
-    const std::vector<float>& operator[](int i) const;
+    float* operator[](int i); // row i
+    const float* operator[](int i) const;
     void fill_row(int row, Vector3f vector);
     void fill_row(int row, Vector2f vector);
     void fill_column(int column, Vector3f vector);
     void fill_column(int column, Vector2f vector);
 private:
-    std::vector<std::vector<float>> data;
+    std::array<float, max_size * max_size> data{};
     int rows{0};
     int columns{0};
 };
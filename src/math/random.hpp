@@ -1,32 +1,49 @@
 #ifndef RANDOM_HPP
 #define RANDOM_HPP
 
-#include <cmath>
-#include <random>
+#include <cstdint>
+
+/*
+Counter-based random numbers: each value is a pure function of a key, e.g. a face index, and of a
+counter numbering the values drawn for that key. Nothing is shared between calls, so the values are
+the same whatever the call order and whichever thread draws them.
+*/
+
+// 64 random bits: the SplitMix64 finalizer of the counter-th state of the stream seeded by key
+inline std::uint64_t random_bits(std::uint64_t key, std::uint64_t counter = 0)
+{
+    const auto mix = [](std::uint64_t z)
+    {
+        z += 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    };
+
+    return mix(mix(key) + counter * 0x9E3779B97F4A7C15ull);
+}
 
 // Returns a random double in range [0.0; 1.0[
-inline double random_double()
+inline double random_double(std::uint64_t key, std::uint64_t counter = 0)
 {
-    static std::uniform_real_distribution<double> distribution(0.0, 1.0);
-    static std::mt19937 generator;
-    return distribution(generator);
+    return static_cast<double>(random_bits(key, counter) >> 11) / 9007199254740992.0; // 53 bits over 2^53
 }
 
 // Returns a random double in range [min; max[
-inline double random_double(double min, double max)
+inline double random_double(double min, double max, std::uint64_t key, std::uint64_t counter = 0)
 {
-    return min + (max - min) * random_double();
+    return min + (max - min) * random_double(key, counter);
 }
 
 // Returns a random integer in range [min; max]
-inline int random_int(int min, int max)
+inline int random_int(int min, int max, std::uint64_t key, std::uint64_t counter = 0)
 {
-    return static_cast<int>(random_double(min, max + 1));
+    return static_cast<int>(random_double(min, max + 1, key, counter));
 }
 
-inline unsigned char random_uchar()
+inline unsigned char random_uchar(std::uint64_t key, std::uint64_t counter = 0)
 {
-    return static_cast<unsigned char>(random_double(0, 256));
+    return static_cast<unsigned char>(random_double(0, 256, key, counter));
 }
 
-#endif // RANDOM_HPP
\ No newline at end of file
+#endif // RANDOM_HPP
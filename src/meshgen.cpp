@@ -0,0 +1,78 @@
+#include "meshgenerator.hpp"
+#include "trianglestream.hpp"
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <string>
+
+/*
+Generate a synthetic mesh for scaling and stress tests.
+Usage: meshgen <sphere|terrain|soup> <triangles> <output.obj|output.trs> [--size <edge length>] [--roughness <height>] [--seed <n>]
+The number of triangles accepts the suffixes K and M, e.g. 100K or 10M. A .trs output is the triangle
+stream format rendered out-of-core by main, for meshes too large to parse from text.
+*/
+static bool parse_count(const std::string& text, std::int64_t& count)
+{
+    std::size_t end = 0;
+    double value = 0.0;
+    try
+    {
+        value = std::stod(text, &end);
+    }
+    catch (const std::exception&)
+    {
+        return false;
+    }
+
+    const std::string suffix{text.substr(end)};
+    if (suffix == "k" || suffix == "K")
+    {
+        value *= 1e3;
+    }
+    else if (suffix == "m" || suffix == "M")
+    {
+        value *= 1e6;
+    }
+    else if (!suffix.empty())
+    {
+        return false;
+    }
+
+    count = static_cast<std::int64_t>(value);
+    return count > 0;
+}
+
+int main(int argc, char* argv[])
+{
+    MeshGeneratorOptions options;
+    if (argc < 4 || !parse_generated_shape(argv[1], options.shape) || !parse_count(argv[2], options.triangles))
+    {
+        std::cerr << "Usage: meshgen <sphere|terrain|soup> <triangles> <output.obj|output.trs> "
+                     "[--size <edge length>] [--roughness <height>] [--seed <n>]\n";
+        return 1;
+    }
+
+    const std::string output{argv[3]};
+    for (int i = 4; i + 1 < argc; i += 2)
+    {
+        const std::string argument{argv[i]};
+        if (argument == "--size")
+        {
+            options.triangle_size = std::stof(argv[i + 1]);
+        }
+        else if (argument == "--roughness")
+        {
+            options.roughness = std::stof(argv[i + 1]);
+        }
+        else if (argument == "--seed")
+        {
+            options.seed = static_cast<std::uint32_t>(std::stoul(argv[i + 1]));
+        }
+    }
+
+    const auto mesh = generate_mesh(options);
+    std::cerr << "Generated " << mesh.number_faces() << " triangles and " << mesh.number_vertices() << " vertices\n";
+
+    const bool stream = output.size() > 4 && output.compare(output.size() - 4, 4, ".trs") == 0;
+    return (stream ? write_triangle_stream(mesh, output) : write_obj_file(mesh, output)) ? 0 : 1;
+}
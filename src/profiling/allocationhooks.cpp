@@ -0,0 +1,161 @@
+// Replacements of the global operator new and delete counting the allocations, see allocations.hpp
+#include "allocations.hpp"
+#include <cstdlib>
+#include <new>
+
+[[maybe_unused]] static const bool hooks_linked = (enable_allocation_tracking(), true);
+
+static void* allocate(std::size_t size)
+{
+    count_allocation(size);
+    return std::malloc(size > 0 ? size : 1);
+}
+
+static void* allocate_aligned(std::size_t size, std::align_val_t alignment)
+{
+    count_allocation(size);
+    const auto bytes = static_cast<std::size_t>(alignment);
+#ifdef _MSC_VER
+    return _aligned_malloc(size > 0 ? size : 1, bytes);
+#else
+    // aligned_alloc requires a multiple of the alignment
+    return std::aligned_alloc(bytes, (size + bytes - 1) / bytes * bytes + (size == 0 ? bytes : 0));
+#endif
+}
+
+static void deallocate_aligned(void* pointer)
+{
+#ifdef _MSC_VER
+    _aligned_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+
+static void* allocate_or_throw(std::size_t size)
+{
+    void* pointer = allocate(size);
+    while (pointer == nullptr)
+    {
+        const auto handler = std::get_new_handler();
+        if (handler == nullptr)
+        {
+            throw std::bad_alloc{};
+        }
+        handler();
+        pointer = std::malloc(size > 0 ? size : 1);
+    }
+
+    return pointer;
+}
+
+static void* allocate_aligned_or_throw(std::size_t size, std::align_val_t alignment)
+{
+    void* pointer = allocate_aligned(size, alignment);
+    if (pointer == nullptr)
+    {
+        throw std::bad_alloc{};
+    }
+
+    return pointer;
+}
+
+void* operator new(std::size_t size)
+{
+    return allocate_or_throw(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return allocate_or_throw(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    return allocate_aligned_or_throw(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return allocate_aligned_or_throw(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocate_aligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocate_aligned(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+    deallocate_aligned(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept
+{
+    deallocate_aligned(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept
+{
+    deallocate_aligned(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept
+{
+    deallocate_aligned(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    deallocate_aligned(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    deallocate_aligned(pointer);
+}
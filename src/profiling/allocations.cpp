@@ -0,0 +1,41 @@
+#include "allocations.hpp"
+#include <atomic>
+
+// Plain counters, so that reading them from operator new neither allocates nor runs a thread_local constructor
+static std::atomic<bool> tracking_enabled{false};
+static std::atomic<std::uint64_t> process_allocation_count{0};
+static std::atomic<std::uint64_t> process_allocated_bytes{0};
+static thread_local AllocationCounts thread_counts;
+
+AllocationCounts operator-(const AllocationCounts& end, const AllocationCounts& start)
+{
+    return AllocationCounts{end.allocations - start.allocations, end.bytes - start.bytes};
+}
+
+bool allocation_tracking_enabled()
+{
+    return tracking_enabled.load(std::memory_order_relaxed);
+}
+
+AllocationCounts process_allocations()
+{
+    return AllocationCounts{process_allocation_count.load(std::memory_order_relaxed), process_allocated_bytes.load(std::memory_order_relaxed)};
+}
+
+AllocationCounts thread_allocations()
+{
+    return thread_counts;
+}
+
+void count_allocation(std::size_t bytes)
+{
+    process_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    process_allocated_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    ++thread_counts.allocations;
+    thread_counts.bytes += bytes;
+}
+
+void enable_allocation_tracking()
+{
+    tracking_enabled.store(true, std::memory_order_relaxed);
+}
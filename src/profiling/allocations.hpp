@@ -0,0 +1,35 @@
+#ifndef ALLOCATIONS_HPP
+#define ALLOCATIONS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+Counts of the heap allocations made through the global operator new. The counting operator new and
+delete of allocationhooks.cpp are linked into the benchmarks, and into main in debug and profiling
+builds (the allocation_hooks object library); without them the counts stay at zero. The profiler adds
+the allocations made within each PROFILE_STAGE to the stage, see ProfileReport.
+*/
+struct AllocationCounts
+{
+    std::uint64_t allocations{0};
+    std::uint64_t bytes{0};
+};
+
+// Counts of end minus start
+AllocationCounts operator-(const AllocationCounts& end, const AllocationCounts& start);
+
+// True if the counting operator new is linked into the executable
+bool allocation_tracking_enabled();
+
+// Allocations of every thread since the program started
+AllocationCounts process_allocations();
+
+// Allocations of the calling thread since it started
+AllocationCounts thread_allocations();
+
+// Implementation of the hooks: record an allocation of the calling thread
+void count_allocation(std::size_t bytes);
+void enable_allocation_tracking();
+
+#endif // ALLOCATIONS_HPP
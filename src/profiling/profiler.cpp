@@ -0,0 +1,320 @@
+#include "profiler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+const char* profile_name(ProfileStage stage)
+{
+    static const char* const names[number_profile_stages]{"mesh_loading", "vertex_shading", "setup", "rasterization",
+                                                          "fragment_shading", "texture_fetch", "output_encoding"};
+    return names[static_cast<int>(stage)];
+}
+
+const char* profile_name(ProfileCounter counter)
+{
+    static const char* const names[number_profile_counters]{"triangles_in", "triangles_culled", "triangles_clipped",
+                                                            "triangles_rasterized", "fragments_tested", "fragments_passed",
+                                                            "fragments_shaded", "helper_lanes", "pixels_covered"};
+    return names[static_cast<int>(counter)];
+}
+
+double ProfileReport::overdraw() const
+{
+    const auto pixels = counters[static_cast<int>(ProfileCounter::PixelsCovered)];
+    return pixels > 0 ? double(counters[static_cast<int>(ProfileCounter::FragmentsShaded)]) / pixels : 0.0;
+}
+
+#ifdef TINY_RENDERER_PROFILING
+
+struct TraceEvent
+{
+    std::string name;
+    std::int64_t start;
+    std::int64_t duration;
+    int thread;
+};
+
+/*
+Data recorded by one thread. The totals are only written by their thread, so relaxed loads and stores
+are enough (no read-modify-write); they are atomic for the reports taken from other threads
+*/
+struct ThreadProfile
+{
+    std::array<std::atomic<std::int64_t>, number_profile_stages> stage_nanoseconds{};
+    std::array<std::atomic<std::uint64_t>, number_profile_stages> stage_calls{};
+    std::array<std::atomic<std::uint64_t>, number_profile_stages> stage_allocations{};
+    std::array<std::atomic<std::uint64_t>, number_profile_stages> stage_allocated_bytes{};
+    std::array<std::atomic<std::uint64_t>, number_profile_counters> counters{};
+    std::mutex events_mutex;
+    std::vector<TraceEvent> events;
+    int thread{0};
+};
+
+// Live threads, and the data of the threads that exited since the last reset
+struct ProfileRegistry
+{
+    std::mutex mutex;
+    std::vector<ThreadProfile*> threads;
+    ProfileReport retired;
+    std::vector<TraceEvent> retired_events;
+    int next_thread{0};
+    std::atomic<std::int64_t> epoch{std::chrono::steady_clock::now().time_since_epoch().count()};
+};
+
+static ProfileRegistry& registry()
+{
+    static ProfileRegistry profile_registry;
+    return profile_registry;
+}
+
+static void merge(const ThreadProfile& profile, ProfileReport& report)
+{
+    for (int i = 0; i < number_profile_stages; ++i)
+    {
+        report.stage_ms[i] += profile.stage_nanoseconds[i].load(std::memory_order_relaxed) / 1e6;
+        report.stage_calls[i] += profile.stage_calls[i].load(std::memory_order_relaxed);
+        report.stage_allocations[i] += profile.stage_allocations[i].load(std::memory_order_relaxed);
+        report.stage_allocated_bytes[i] += profile.stage_allocated_bytes[i].load(std::memory_order_relaxed);
+    }
+    for (int i = 0; i < number_profile_counters; ++i)
+    {
+        report.counters[i] += profile.counters[i].load(std::memory_order_relaxed);
+    }
+}
+
+// Registers the thread on first use; on exit its data is moved to the retired totals
+class ThreadProfileOwner
+{
+public:
+    ThreadProfileOwner(): profile_{std::make_unique<ThreadProfile>()}
+    {
+        auto& profiles = registry();
+        std::lock_guard<std::mutex> lock{profiles.mutex};
+        profile_->thread = profiles.next_thread++;
+        profiles.threads.emplace_back(profile_.get());
+    }
+
+    ~ThreadProfileOwner()
+    {
+        auto& profiles = registry();
+        std::lock_guard<std::mutex> lock{profiles.mutex};
+        merge(*profile_, profiles.retired);
+        profiles.retired_events.insert(profiles.retired_events.end(), std::make_move_iterator(profile_->events.begin()),
+                                       std::make_move_iterator(profile_->events.end()));
+        profiles.threads.erase(std::find(profiles.threads.begin(), profiles.threads.end(), profile_.get()));
+    }
+
+    ThreadProfile& profile()
+    {
+        return *profile_;
+    }
+private:
+    std::unique_ptr<ThreadProfile> profile_;
+};
+
+static ThreadProfile& thread_profile()
+{
+    thread_local ThreadProfileOwner owner;
+    return owner.profile();
+}
+
+template<typename T>
+static void add(std::atomic<T>& total, T amount)
+{
+    total.store(total.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+void profile_add_stage_time(ProfileStage stage, std::int64_t nanoseconds, const AllocationCounts& allocated)
+{
+    auto& profile = thread_profile();
+    add(profile.stage_nanoseconds[static_cast<int>(stage)], nanoseconds);
+    add(profile.stage_calls[static_cast<int>(stage)], std::uint64_t{1});
+    if (allocated.allocations > 0)
+    {
+        add(profile.stage_allocations[static_cast<int>(stage)], allocated.allocations);
+        add(profile.stage_allocated_bytes[static_cast<int>(stage)], allocated.bytes);
+    }
+}
+
+void profile_add_count(ProfileCounter counter, std::uint64_t amount)
+{
+    add(thread_profile().counters[static_cast<int>(counter)], amount);
+}
+
+void profile_add_event(std::string name, std::int64_t start_nanoseconds, std::int64_t duration_nanoseconds)
+{
+    auto& profile = thread_profile();
+    std::lock_guard<std::mutex> lock{profile.events_mutex};
+    profile.events.emplace_back(TraceEvent{std::move(name), start_nanoseconds, duration_nanoseconds, profile.thread});
+}
+
+std::int64_t profile_now()
+{
+    const std::chrono::nanoseconds now{std::chrono::steady_clock::now().time_since_epoch()};
+    return static_cast<std::int64_t>(now.count()) - registry().epoch.load(std::memory_order_relaxed);
+}
+
+bool profiling_enabled()
+{
+    return true;
+}
+
+void reset_profile()
+{
+    auto& profiles = registry();
+    std::lock_guard<std::mutex> lock{profiles.mutex};
+    for (auto* profile: profiles.threads)
+    {
+        for (auto& time: profile->stage_nanoseconds)
+        {
+            time.store(0, std::memory_order_relaxed);
+        }
+        for (auto& calls: profile->stage_calls)
+        {
+            calls.store(0, std::memory_order_relaxed);
+        }
+        for (auto& allocations: profile->stage_allocations)
+        {
+            allocations.store(0, std::memory_order_relaxed);
+        }
+        for (auto& bytes: profile->stage_allocated_bytes)
+        {
+            bytes.store(0, std::memory_order_relaxed);
+        }
+        for (auto& counter: profile->counters)
+        {
+            counter.store(0, std::memory_order_relaxed);
+        }
+        std::lock_guard<std::mutex> events_lock{profile->events_mutex};
+        profile->events.clear();
+    }
+    profiles.retired = ProfileReport{};
+    profiles.retired_events.clear();
+    const std::chrono::nanoseconds now{std::chrono::steady_clock::now().time_since_epoch()};
+    profiles.epoch.store(static_cast<std::int64_t>(now.count()), std::memory_order_relaxed);
+}
+
+ProfileReport profile_report()
+{
+    auto& profiles = registry();
+    std::lock_guard<std::mutex> lock{profiles.mutex};
+    ProfileReport report{profiles.retired};
+    for (const auto* profile: profiles.threads)
+    {
+        merge(*profile, report);
+    }
+
+    return report;
+}
+
+static std::vector<TraceEvent> trace_events()
+{
+    auto& profiles = registry();
+    std::lock_guard<std::mutex> lock{profiles.mutex};
+    std::vector<TraceEvent> events{profiles.retired_events};
+    for (auto* profile: profiles.threads)
+    {
+        std::lock_guard<std::mutex> events_lock{profile->events_mutex};
+        events.insert(events.end(), profile->events.begin(), profile->events.end());
+    }
+    std::sort(events.begin(), events.end(), [](const TraceEvent& lhs, const TraceEvent& rhs) { return lhs.start < rhs.start; });
+
+    return events;
+}
+
+#else
+
+bool profiling_enabled()
+{
+    return false;
+}
+
+void reset_profile()
+{
+}
+
+ProfileReport profile_report()
+{
+    return ProfileReport{};
+}
+
+#endif // TINY_RENDERER_PROFILING
+
+static std::string json_string(const std::string& text)
+{
+    std::string quoted{"\""};
+    for (const char character: text)
+    {
+        if (character == '"' || character == '\\')
+        {
+            quoted += '\\';
+        }
+        quoted += character;
+    }
+
+    return quoted + "\"";
+}
+
+bool write_profile_json(const std::string& filename)
+{
+    std::ofstream output{filename};
+    if (!output.is_open())
+    {
+        return false;
+    }
+
+    const auto report = profile_report();
+    output << std::fixed << std::setprecision(3);
+    output << "{\n  \"enabled\": " << (profiling_enabled() ? "true" : "false") << ",\n  \"allocation_tracking\": "
+           << (allocation_tracking_enabled() ? "true" : "false") << ",\n  \"stages\": {";
+    for (int i = 0; i < number_profile_stages; ++i)
+    {
+        output << (i == 0 ? "\n" : ",\n") << "    " << json_string(profile_name(ProfileStage(i))) << ": {\"ms\": "
+               << report.stage_ms[i] << ", \"calls\": " << report.stage_calls[i] << ", \"allocations\": "
+               << report.stage_allocations[i] << ", \"allocated_bytes\": " << report.stage_allocated_bytes[i] << "}";
+    }
+    output << "\n  },\n  \"counters\": {";
+    for (int i = 0; i < number_profile_counters; ++i)
+    {
+        output << (i == 0 ? "\n" : ",\n") << "    " << json_string(profile_name(ProfileCounter(i))) << ": " << report.counters[i];
+    }
+    output << "\n  },\n  \"overdraw\": " << report.overdraw() << "\n}\n";
+
+    return static_cast<bool>(output);
+}
+
+bool write_chrome_trace(const std::string& filename)
+{
+    std::ofstream output{filename};
+    if (!output.is_open())
+    {
+        return false;
+    }
+
+    // Complete events ("ph": "X") with timestamps in microseconds; the counters go to the metadata
+    output << std::fixed << std::setprecision(3);
+    output << "{\n  \"displayTimeUnit\": \"ms\",\n  \"traceEvents\": [";
+#ifdef TINY_RENDERER_PROFILING
+    const auto events = trace_events();
+    for (std::size_t i = 0; i < events.size(); ++i)
+    {
+        output << (i == 0 ? "\n" : ",\n") << "    {\"name\": " << json_string(events[i].name)
+               << ", \"cat\": \"renderer\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << events[i].thread
+               << ", \"ts\": " << events[i].start / 1e3 << ", \"dur\": " << events[i].duration / 1e3 << "}";
+    }
+#endif
+    const auto report = profile_report();
+    output << "\n  ],\n  \"otherData\": {";
+    for (int i = 0; i < number_profile_counters; ++i)
+    {
+        output << (i == 0 ? "" : ", ") << json_string(profile_name(ProfileCounter(i))) << ": " << report.counters[i];
+    }
+    output << "}\n}\n";
+
+    return static_cast<bool>(output);
+}
@@ -0,0 +1,132 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include "allocations.hpp"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+/*
+Per-stage timing and counters of the renderer. The PROFILE_* macros compile to nothing, arguments
+included, unless the build is configured with -DTINY_RENDERER_PROFILING=ON; the functions below are
+always available and report zeros in that case.
+- PROFILE_STAGE(stage): add the time until the end of the scope to a ProfileStage, and the heap
+  allocations of the thread within it when they are tracked (see allocations.hpp). Cheap enough for
+  the per-fragment stages; stage times are inclusive, e.g. rasterization contains the fragment
+  shading it invokes, which contains the texture fetches.
+- PROFILE_SCOPE(name): record the scope as an event of the Chrome trace, for coarse scopes only
+  (a frame, a mesh load, the raster stage of a pipelined frame), not per batch or per tile.
+- PROFILE_COUNT(counter, amount): add to a ProfileCounter. The tiled renders count the triangles and
+  fragments of rasterize once per tile they overlap.
+Every thread records into buffers of its own, merged when a report is taken.
+*/
+
+enum class ProfileStage
+{
+    MeshLoading,
+    VertexShading,
+    Setup, // triangle setup of the streaming pipeline
+    Rasterization,
+    FragmentShading,
+    TextureFetch,
+    OutputEncoding,
+    Count
+};
+
+enum class ProfileCounter
+{
+    TrianglesIn, // faces submitted to Our GL
+    TrianglesCulled, // rejected by triangle setup: outside of the screen rectangle, or degenerate once snapped to pixels
+    TrianglesClipped, // rasterized with a bounding box clipped by the screen rectangle
+    TrianglesRasterized,
+    FragmentsTested, // pixels covered by a triangle, depth tested
+    FragmentsPassed, // passed the depth test, fragment shader invoked
+    FragmentsShaded, // not discarded by the fragment shader, written
+    HelperLanes, // pixels of the shaded 2x2 quads that are not written: uncovered, clipped or failing the depth test
+    PixelsCovered, // pixels of the frames holding a fragment at the end
+    Count
+};
+
+constexpr int number_profile_stages = static_cast<int>(ProfileStage::Count);
+constexpr int number_profile_counters = static_cast<int>(ProfileCounter::Count);
+
+// Name of the stage or counter in the reports, e.g. "vertex_shading"
+const char* profile_name(ProfileStage stage);
+const char* profile_name(ProfileCounter counter);
+
+struct ProfileReport
+{
+    std::array<double, number_profile_stages> stage_ms{};
+    std::array<std::uint64_t, number_profile_stages> stage_calls{};
+    std::array<std::uint64_t, number_profile_stages> stage_allocations{};
+    std::array<std::uint64_t, number_profile_stages> stage_allocated_bytes{};
+    std::array<std::uint64_t, number_profile_counters> counters{};
+
+    // Fragments written per covered pixel
+    double overdraw() const;
+};
+
+// True if the macros were compiled in
+bool profiling_enabled();
+
+// Discard the timings, counters and trace events recorded so far
+void reset_profile();
+
+// Merge the data of every thread; call while nothing is being rendered
+ProfileReport profile_report();
+
+// Write the stages, counters and overdraw as JSON; returns false if the file cannot be written
+bool write_profile_json(const std::string& filename);
+
+// Write the trace events in the Chrome trace event format, viewable in chrome://tracing or Perfetto
+bool write_chrome_trace(const std::string& filename);
+
+#ifdef TINY_RENDERER_PROFILING
+
+// Implementation of the macros: record into the buffers of the calling thread
+void profile_add_stage_time(ProfileStage stage, std::int64_t nanoseconds, const AllocationCounts& allocated);
+void profile_add_count(ProfileCounter counter, std::uint64_t amount);
+void profile_add_event(std::string name, std::int64_t start_nanoseconds, std::int64_t duration_nanoseconds);
+std::int64_t profile_now(); // nanoseconds since the last reset_profile
+
+class ProfileStageTimer
+{
+public:
+    explicit ProfileStageTimer(ProfileStage stage): stage_{stage}, allocations_{thread_allocations()}, start_{profile_now()} {}
+    ~ProfileStageTimer() { profile_add_stage_time(stage_, profile_now() - start_, thread_allocations() - allocations_); }
+    ProfileStageTimer(const ProfileStageTimer&) = delete;
+    ProfileStageTimer& operator=(const ProfileStageTimer&) = delete;
+private:
+    ProfileStage stage_;
+    AllocationCounts allocations_;
+    std::int64_t start_;
+};
+
+class ProfileScopeEvent
+{
+public:
+    explicit ProfileScopeEvent(std::string name): name_{std::move(name)}, start_{profile_now()} {}
+    ~ProfileScopeEvent() { profile_add_event(std::move(name_), start_, profile_now() - start_); }
+    ProfileScopeEvent(const ProfileScopeEvent&) = delete;
+    ProfileScopeEvent& operator=(const ProfileScopeEvent&) = delete;
+private:
+    std::string name_;
+    std::int64_t start_;
+};
+
+#define PROFILE_CONCATENATE_IMPL(a, b) a##b
+#define PROFILE_CONCATENATE(a, b) PROFILE_CONCATENATE_IMPL(a, b)
+#define PROFILE_STAGE(stage) ProfileStageTimer PROFILE_CONCATENATE(profile_stage_, __LINE__){ProfileStage::stage}
+#define PROFILE_SCOPE(name) ProfileScopeEvent PROFILE_CONCATENATE(profile_scope_, __LINE__){name}
+#define PROFILE_COUNT(counter, amount) profile_add_count(ProfileCounter::counter, static_cast<std::uint64_t>(amount))
+
+#else
+
+#define PROFILE_STAGE(stage) ((void)0)
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_COUNT(counter, amount) ((void)0)
+
+#endif // TINY_RENDERER_PROFILING
+
+#endif // PROFILER_HPP
@@ -0,0 +1,98 @@
+#include "debugtargets.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iterator>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define HAS_TIME_STAMP_COUNTER
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAS_TIME_STAMP_COUNTER
+#endif
+
+void DebugTargets::reset(int width, int height)
+{
+    this->width = width;
+    this->height = height;
+    const std::size_t size = static_cast<std::size_t>(width) * height;
+    depth_tests.assign(size, 0);
+    shader_invocations.assign(size, 0);
+    shader_cycles.assign(size, 0);
+    texel_footprint.assign(size, 0.0f);
+}
+
+std::uint64_t debug_cycle_counter()
+{
+#ifdef HAS_TIME_STAMP_COUNTER
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// Black, blue, cyan, green, yellow and red at t = 0, 0.2, ..., 1, linearly interpolated
+static TGAColor heat_color(double t)
+{
+    static const std::array<std::array<double, 3>, 6> stops{{{0, 0, 0}, {0, 0, 255}, {0, 255, 255}, {0, 255, 0}, {255, 255, 0}, {255, 0, 0}}};
+    t = std::min(std::max(t, 0.0), 1.0) * (stops.size() - 1);
+    const std::size_t segment = std::min(static_cast<std::size_t>(t), stops.size() - 2);
+    const double fraction = t - segment;
+
+    std::array<unsigned char, 3> rgb;
+    for (int i = 0; i < 3; ++i)
+    {
+        rgb[i] = static_cast<unsigned char>(std::lround(stops[segment][i] + fraction * (stops[segment + 1][i] - stops[segment][i])));
+    }
+
+    return TGAColor{rgb[0], rgb[1], rgb[2], 255};
+}
+
+template<typename T>
+static double write_values(const std::vector<T>& values, TGAImage& image, double percentile)
+{
+    std::vector<T> nonzero;
+    std::copy_if(values.begin(), values.end(), std::back_inserter(nonzero), [](T value) { return value != 0; });
+    if (nonzero.empty())
+    {
+        return 0.0;
+    }
+
+    const double fraction = std::min(std::max(percentile, 0.0), 1.0);
+    const auto rank = static_cast<std::size_t>(std::ceil(fraction * nonzero.size()));
+    const auto saturation = nonzero.begin() + (rank > 0 ? rank - 1 : 0);
+    std::nth_element(nonzero.begin(), saturation, nonzero.end());
+    const double maximum = static_cast<double>(*saturation);
+
+    const int width = image.get_width();
+    for (int y = 0; y < image.get_height(); ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            const T value = values[x + y * width];
+            if (value != 0)
+            {
+                image.set(x, y, heat_color(value / maximum));
+            }
+        }
+    }
+
+    return maximum;
+}
+
+double write_heatmap(const std::vector<std::uint32_t>& values, TGAImage& image, double percentile)
+{
+    return write_values(values, image, percentile);
+}
+
+double write_heatmap(const std::vector<std::uint64_t>& values, TGAImage& image, double percentile)
+{
+    return write_values(values, image, percentile);
+}
+
+double write_heatmap(const std::vector<float>& values, TGAImage& image, double percentile)
+{
+    return write_values(values, image, percentile);
+}
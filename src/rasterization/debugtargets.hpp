@@ -0,0 +1,41 @@
+#ifndef DEBUG_TARGETS_HPP
+#define DEBUG_TARGETS_HPP
+
+#include "tgaimage.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+Per-pixel cost of a frame, accumulated by rasterize when attached to a render context (see
+RenderContext::set_debug_targets): how many fragments were depth tested, how many invoked the
+fragment shader, the approximate cycles spent in Shader::fragment (time stamp counter on x86,
+nanoseconds elsewhere), and the texel footprint of the fragment written last (see Shader::texture_footprint).
+Rows start from the bottom of the image, like the color target.
+*/
+struct DebugTargets
+{
+    int width{0};
+    int height{0};
+    std::vector<std::uint32_t> depth_tests;
+    std::vector<std::uint32_t> shader_invocations;
+    std::vector<std::uint64_t> shader_cycles;
+    std::vector<float> texel_footprint;
+
+    // Size the targets to width x height and zero them
+    void reset(int width, int height);
+};
+
+// Read the cycle counter used for DebugTargets::shader_cycles
+std::uint64_t debug_cycle_counter();
+
+/*
+Color the values of a debug target on a black, blue, cyan, green, yellow, red scale into image, which must have
+the size of the targets; black is zero. The scale saturates at the given percentile of the nonzero values,
+so a few outliers (e.g. a thread preempted during a fragment) do not darken the rest; returns the saturation value
+*/
+double write_heatmap(const std::vector<std::uint32_t>& values, TGAImage& image, double percentile = 1.0);
+double write_heatmap(const std::vector<std::uint64_t>& values, TGAImage& image, double percentile = 1.0);
+double write_heatmap(const std::vector<float>& values, TGAImage& image, double percentile = 1.0);
+
+#endif // DEBUG_TARGETS_HPP
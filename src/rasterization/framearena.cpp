@@ -0,0 +1,74 @@
+#include "framearena.hpp"
+#include <algorithm>
+#include <cstdint>
+
+FrameArena::FrameArena(std::size_t block_size): block_size_{std::max<std::size_t>(block_size, 1)}
+{}
+
+void* FrameArena::allocate(std::size_t size, std::size_t alignment)
+{
+    while (true)
+    {
+        if (current_ < blocks_.size())
+        {
+            const auto& block = blocks_[current_];
+            const auto base = reinterpret_cast<std::uintptr_t>(block.memory.get());
+            const auto aligned = (base + offset_ + alignment - 1) & ~static_cast<std::uintptr_t>(alignment - 1);
+            const std::size_t end = aligned - base + size;
+            if (end <= block.size)
+            {
+                offset_ = end;
+                return reinterpret_cast<void*>(aligned);
+            }
+
+            // Blocks kept from a previous frame are reused before chaining a new one
+            if (current_ + 1 < blocks_.size())
+            {
+                used_before_ += offset_;
+                ++current_;
+                offset_ = 0;
+                continue;
+            }
+        }
+
+        // Without new[] value-initialization: the arena hands out uninitialized storage
+        const std::size_t new_size = std::max(block_size_, size + alignment);
+        if (!blocks_.empty())
+        {
+            used_before_ += offset_;
+        }
+        current_ = blocks_.size();
+        offset_ = 0;
+        blocks_.emplace_back(Block{std::unique_ptr<unsigned char[]>(new unsigned char[new_size]), new_size});
+    }
+}
+
+void FrameArena::reset()
+{
+    if (blocks_.size() > 1)
+    {
+        const std::size_t total = capacity();
+        blocks_.clear();
+        blocks_.emplace_back(Block{std::unique_ptr<unsigned char[]>(new unsigned char[total]), total});
+    }
+
+    current_ = 0;
+    offset_ = 0;
+    used_before_ = 0;
+}
+
+std::size_t FrameArena::bytes_used() const
+{
+    return used_before_ + offset_;
+}
+
+std::size_t FrameArena::capacity() const
+{
+    std::size_t total = 0;
+    for (const auto& block: blocks_)
+    {
+        total += block.size;
+    }
+
+    return total;
+}
@@ -0,0 +1,54 @@
+#ifndef FRAME_ARENA_HPP
+#define FRAME_ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+/*
+Linear allocator for the transient data of a frame (transformed vertices, tile bins...), used by one
+thread at a time. Allocating bumps an offset in the current block; nothing is freed individually and
+no destructor runs, the whole arena is recycled by reset in O(1). When a frame needs more than the
+first block, further blocks are chained and reset merges them into one block of the total size, so
+after the first frames a steady workload allocates from a single block without touching the heap.
+*/
+class FrameArena
+{
+public:
+    explicit FrameArena(std::size_t block_size = 64 * 1024);
+    FrameArena(FrameArena&&) = default;
+    FrameArena& operator=(FrameArena&&) = default;
+
+    // Uninitialized storage, valid until the next reset
+    void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t));
+
+    // Uninitialized storage for count objects of type T
+    template<typename T>
+    T* allocate(std::size_t count)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "the arena never runs destructors");
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // Release every allocation at once; the blocks are kept for the next frame
+    void reset();
+
+    // Bytes handed out since the last reset (alignment padding included), and bytes reserved by the blocks
+    std::size_t bytes_used() const;
+    std::size_t capacity() const;
+private:
+    struct Block
+    {
+        std::unique_ptr<unsigned char[]> memory;
+        std::size_t size;
+    };
+
+    std::vector<Block> blocks_;
+    std::size_t block_size_;
+    std::size_t current_{0}; // block being filled
+    std::size_t offset_{0}; // in the current block
+    std::size_t used_before_{0}; // bytes used in the blocks before the current one
+};
+
+#endif // FRAME_ARENA_HPP
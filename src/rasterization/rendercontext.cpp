@@ -0,0 +1,162 @@
+#include "rendercontext.hpp"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+static constexpr unsigned char clear_color_bit = 1;
+static constexpr unsigned char clear_depth_bit = 2;
+
+int covered_pixels(const DepthBuffer& depth)
+{
+    return static_cast<int>(std::count_if(depth.begin(), depth.end(), [](float value)
+    {
+        return value != std::numeric_limits<float>::lowest();
+    }));
+}
+
+RenderContext::RenderContext(int width, int height, int tile_size): 
+    width_{0}, height_{0}, tile_size_{std::max(1, tile_size)}, tiles_x_{0}, tiles_y_{0}
+{
+    resize(width, height);
+}
+
+int RenderContext::width() const
+{
+    return width_;
+}
+
+int RenderContext::height() const
+{
+    return height_;
+}
+
+TGAImage& RenderContext::color()
+{
+    return color_;
+}
+
+const TGAImage& RenderContext::color() const
+{
+    return color_;
+}
+
+DepthBuffer& RenderContext::depth()
+{
+    return depth_;
+}
+
+const DepthBuffer& RenderContext::depth() const
+{
+    return depth_;
+}
+
+void RenderContext::resize(int width, int height)
+{
+    if (width == width_ && height == height_)
+    {
+        return;
+    }
+
+    width_ = width;
+    height_ = height;
+    tiles_x_ = (width + tile_size_ - 1) / tile_size_;
+    tiles_y_ = (height + tile_size_ - 1) / tile_size_;
+    color_ = TGAImage{width, height, TGAImage::RGB};
+    depth_.assign(width * height, std::numeric_limits<float>::lowest());
+    pending_clears_.assign(tiles_x_ * tiles_y_, 0);
+    pending_tiles_ = 0;
+}
+
+void RenderContext::clear(bool clear_color)
+{
+    const unsigned char mask = clear_depth_bit | (clear_color ? clear_color_bit : 0);
+    std::fill(pending_clears_.begin(), pending_clears_.end(), mask);
+    pending_tiles_ = static_cast<int>(pending_clears_.size());
+    arena_.reset();
+}
+
+void RenderContext::touch(Vector2i min, Vector2i max)
+{
+    if (pending_tiles_ == 0)
+    {
+        return;
+    }
+
+    const int min_tile_x = std::max(0, min.x / tile_size_);
+    const int min_tile_y = std::max(0, min.y / tile_size_);
+    const int max_tile_x = std::min(tiles_x_ - 1, max.x / tile_size_);
+    const int max_tile_y = std::min(tiles_y_ - 1, max.y / tile_size_);
+
+    for (int tile_y = min_tile_y; tile_y <= max_tile_y; ++tile_y)
+    {
+        for (int tile_x = min_tile_x; tile_x <= max_tile_x; ++tile_x)
+        {
+            clear_tile(tile_x, tile_y);
+        }
+    }
+}
+
+void RenderContext::resolve()
+{
+    for (int tile_y = 0; pending_tiles_ > 0 && tile_y < tiles_y_; ++tile_y)
+    {
+        for (int tile_x = 0; tile_x < tiles_x_; ++tile_x)
+        {
+            clear_tile(tile_x, tile_y);
+        }
+    }
+}
+
+TGAImage RenderContext::swap_color(TGAImage&& next)
+{
+    resolve();
+    TGAImage finished{std::move(color_)};
+    color_ = std::move(next);
+    return finished;
+}
+
+void RenderContext::set_debug_targets(DebugTargets* targets)
+{
+    debug_targets_ = targets;
+}
+
+DebugTargets* RenderContext::debug_targets() const
+{
+    return debug_targets_;
+}
+
+FrameArena& RenderContext::arena()
+{
+    return arena_;
+}
+
+void RenderContext::clear_tile(int tile_x, int tile_y)
+{
+    auto& mask = pending_clears_[tile_x + tile_y * tiles_x_];
+    if (mask == 0)
+    {
+        return;
+    }
+
+    const int x0 = tile_x * tile_size_;
+    const int y0 = tile_y * tile_size_;
+    const int tile_width = std::min(tile_size_, width_ - x0);
+    const int tile_height = std::min(tile_size_, height_ - y0);
+    const int bytespp = color_.get_bytespp();
+
+    for (int y = y0; y < y0 + tile_height; ++y)
+    {
+        if (mask & clear_depth_bit)
+        {
+            std::fill_n(depth_.begin() + (x0 + y * width_), tile_width, std::numeric_limits<float>::lowest());
+        }
+
+        if (mask & clear_color_bit)
+        {
+            std::memset(color_.buffer() + (x0 + y * width_) * bytespp, 0, tile_width * bytespp);
+        }
+    }
+
+    mask = 0;
+    --pending_tiles_;
+}
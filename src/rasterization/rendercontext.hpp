@@ -0,0 +1,108 @@
+#ifndef RENDER_CONTEXT_HPP
+#define RENDER_CONTEXT_HPP
+
+#include "framearena.hpp"
+#include "tgaimage.h"
+#include "vector.hpp"
+#include <cstddef>
+#include <new>
+#include <vector>
+
+struct DebugTargets;
+
+// Allocator for std::vector returning storage aligned to Alignment bytes (a cache line by default)
+template<typename T, std::size_t Alignment = 64>
+struct AlignedAllocator
+{
+    using value_type = T;
+
+    template<typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{Alignment}));
+    }
+
+    void deallocate(T* pointer, std::size_t)
+    {
+        ::operator delete(pointer, std::align_val_t{Alignment});
+    }
+
+    template<typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+
+    template<typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+// Depth values of the pixels, row by row starting from the bottom of the image
+using DepthBuffer = std::vector<float, AlignedAllocator<float>>;
+
+// Number of pixels holding a fragment, i.e. with a depth above the clear value
+int covered_pixels(const DepthBuffer& depth);
+
+/*
+Color and depth targets reused across frames and scenes. Clearing is lazy: clear only flags the
+tiles of the screen, and each flagged tile is cleared the first time a triangle touches it (see
+touch). resolve clears the tiles that were never touched, so the targets are complete and valid.
+Resizing to the same dimensions does not reallocate. The context also holds the frame arena of the
+frame drawn into it, reset by clear.
+*/
+class RenderContext
+{
+public:
+    RenderContext(int width, int height, int tile_size = 64);
+
+    int width() const;
+    int height() const;
+    TGAImage& color();
+    const TGAImage& color() const;
+    DepthBuffer& depth();
+    const DepthBuffer& depth() const;
+
+    void resize(int width, int height);
+
+    // Flag every tile to be cleared (the color target only if clear_color is true) and reset the arena; O(number of tiles)
+    void clear(bool clear_color = true);
+
+    // Apply the pending clears of the tiles overlapped by the screen rectangle [min, max] (inclusive)
+    void touch(Vector2i min, Vector2i max);
+
+    // Apply every pending clear
+    void resolve();
+
+    // Hand the color target over (pending color clears are applied first) and continue on next, which must be clear and of the same size
+    TGAImage swap_color(TGAImage&& next);
+
+    // Debug targets accumulated by rasterize into this context, of the same size; nullptr (the default) detaches them
+    void set_debug_targets(DebugTargets* targets);
+    DebugTargets* debug_targets() const;
+
+    // Transient storage of the frame, for the thread drawing it
+    FrameArena& arena();
+private:
+    void clear_tile(int tile_x, int tile_y);
+
+    int width_;
+    int height_;
+    int tile_size_;
+    int tiles_x_;
+    int tiles_y_;
+    int pending_tiles_{0};
+    TGAImage color_;
+    DepthBuffer depth_;
+    std::vector<unsigned char> pending_clears_; // bit mask of the targets to clear, per tile
+    DebugTargets* debug_targets_{nullptr};
+    FrameArena arena_;
+};
+
+#endif // RENDER_CONTEXT_HPP
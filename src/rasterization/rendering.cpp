@@ -1,7 +1,7 @@
 #include "rendering.hpp"
+#include "debugtargets.hpp"
 #include "geometry.hpp"
-#include "random.hpp"
-#include "rendering.hpp"
+#include "profiler.hpp"
 #include "shader.hpp"
 #include "trianglemesh.hpp"
 #include <algorithm>
@@ -128,11 +128,12 @@ void line_sweeping_fill_triangle(Vector2i vertex0, Vector2i vertex1, Vector2i ve
     }
 }
 
-void fill_colored_triangle(Vector2i vertex0, Vector2i vertex1, Vector2i vertex2, TGAImage& image, const TGAColor& color)
+void fill_colored_triangle(Vector2i vertex0, Vector2i vertex1, Vector2i vertex2, TGAImage& image, const TGAColor& color,
+                           int first_row, int last_row)
 {
     Vector2i min_bounding_box{image.get_width() - 1, image.get_height() - 1};
     Vector2i max_bounding_box{0, 0};
-    Vector2i clamp{image.get_width() - 1, image.get_height() - 1};
+    Vector2i clamp{image.get_width() - 1, std::min(image.get_height(), last_row) - 1};
     const std::array<Vector2i, 3> vertices{vertex0, vertex1, vertex2};
 
     for (int i = 0; i < vertices.size(); ++i)
@@ -143,6 +144,7 @@ void fill_colored_triangle(Vector2i vertex0, Vector2i vertex1, Vector2i vertex2,
         max_bounding_box.x = std::min(clamp.x, std::max(max_bounding_box.x, vertices[i].x));
         max_bounding_box.y = std::min(clamp.y, std::max(max_bounding_box.y, vertices[i].y));
     }
+    min_bounding_box.y = std::max(min_bounding_box.y, first_row);
 
     Vector2i draw_point;
     for (draw_point.x = min_bounding_box.x; draw_point.x <= max_bounding_box.x; ++draw_point.x)
@@ -157,7 +159,7 @@ void fill_colored_triangle(Vector2i vertex0, Vector2i vertex1, Vector2i vertex2,
     }
 }
 
-void fill_colored_triangle(Vector3i vertex0, Vector3i vertex1, Vector3i vertex2, std::vector<float>& depth_buffer, TGAImage& image, const TGAColor& color)
+void fill_colored_triangle(Vector3i vertex0, Vector3i vertex1, Vector3i vertex2, DepthBuffer& depth_buffer, TGAImage& image, const TGAColor& color)
 {
     Vector2i min_bounding_box{std::numeric_limits<int>::max(), std::numeric_limits<int>::max()};
     Vector2i max_bounding_box{std::numeric_limits<int>::min(), std::numeric_limits<int>::min()};
@@ -199,7 +201,7 @@ void fill_colored_triangle(Vector3i vertex0, Vector3i vertex1, Vector3i vertex2,
     }
 }
 
-void fill_textured_triangle(const std::array<Vector3i, 3>& vertices, const std::array<Vector2f, 3>& uv_coordinates, const TriangleMesh& model, std::vector<float>& depth_buffer, TGAImage& image)
+void fill_textured_triangle(const std::array<Vector3i, 3>& vertices, const std::array<Vector2f, 3>& uv_coordinates, const TriangleMesh& model, DepthBuffer& depth_buffer, TGAImage& image)
 {
     Vector2i min_bounding_box{std::numeric_limits<int>::max(), std::numeric_limits<int>::max()};
     Vector2i max_bounding_box{std::numeric_limits<int>::min(), std::numeric_limits<int>::min()};
@@ -242,7 +244,7 @@ void fill_textured_triangle(const std::array<Vector3i, 3>& vertices, const std::
     }
 }
 
-void fill_textured_triangle(const std::array<Vector3i, 3>& vertices, const std::array<Vector2f, 3>& uv_coordinates, float light_intensity, const TriangleMesh& model, std::vector<float>& depth_buffer, TGAImage& image)
+void fill_textured_triangle(const std::array<Vector3i, 3>& vertices, const std::array<Vector2f, 3>& uv_coordinates, float light_intensity, const TriangleMesh& model, DepthBuffer& depth_buffer, TGAImage& image)
 {
     Vector2i min_bounding_box{std::numeric_limits<int>::max(), std::numeric_limits<int>::max()};
     Vector2i max_bounding_box{std::numeric_limits<int>::min(), std::numeric_limits<int>::min()};
@@ -286,7 +288,7 @@ void fill_textured_triangle(const std::array<Vector3i, 3>& vertices, const std::
     }
 }
 
-void fill_triangle_gouraud(const std::array<Vector3i, 3>& vertices, const std::array<float, 3>& intensities, std::vector<float>& depth_buffer, TGAImage& image)
+void fill_triangle_gouraud(const std::array<Vector3i, 3>& vertices, const std::array<float, 3>& intensities, DepthBuffer& depth_buffer, TGAImage& image)
 {
     Vector2i min_bounding_box{std::numeric_limits<int>::max(), std::numeric_limits<int>::max()};
     Vector2i max_bounding_box{std::numeric_limits<int>::min(), std::numeric_limits<int>::min()};
@@ -328,42 +330,181 @@ void fill_triangle_gouraud(const std::array<Vector3i, 3>& vertices, const std::a
     }
 }
 
-void rasterize(const std::array<Vector3f, 3>& vertices, Shader& shader, TGAImage& image, std::vector<float>& depth_buffer)
+// Bounding box of the triangle clipped to the screen rectangle of size dimensions that starts at origin
+static std::array<Vector2i, 2> clipped_bounding_box(const std::array<Vector3f, 3>& vertices, Vector2i origin, Vector2i dimensions)
 {
     const Vector2i min_bounding_box = cast<int>(
-        Vector2f{std::max(0.0f, std::min(std::min(vertices[0].x, vertices[1].x), vertices[2].x)),
-                 std::max(0.0f, std::min(std::min(vertices[0].y, vertices[1].y), vertices[2].y))});
+        Vector2f{std::max(float(origin.x), std::min(std::min(vertices[0].x, vertices[1].x), vertices[2].x)),
+                 std::max(float(origin.y), std::min(std::min(vertices[0].y, vertices[1].y), vertices[2].y))});
     const Vector2i max_bounding_box = cast<int>(
-        Vector2f{std::min(image.get_width() - 1.0f, std::max(std::max(vertices[0].x, vertices[1].x), vertices[2].x)),
-                 std::min(image.get_height() - 1.0f, std::max(std::max(vertices[0].y, vertices[1].y), vertices[2].y))});
+        Vector2f{std::min(origin.x + dimensions.x - 1.0f, std::max(std::max(vertices[0].x, vertices[1].x), vertices[2].x)),
+                 std::min(origin.y + dimensions.y - 1.0f, std::max(std::max(vertices[0].y, vertices[1].y), vertices[2].y))});
 
-    Vector3i draw_point;
-    for (draw_point.x = min_bounding_box.x; draw_point.x <= max_bounding_box.x; ++draw_point.x)
+    return {min_bounding_box, max_bounding_box};
+}
+
+bool covers_pixels(const std::array<Vector3f, 3>& vertices, Vector2i dimensions, Vector2i origin)
+{
+    const auto bounding_box = clipped_bounding_box(vertices, origin, dimensions);
+    if (bounding_box[1].x < bounding_box[0].x || bounding_box[1].y < bounding_box[0].y)
     {
-        for (draw_point.y = min_bounding_box.y; draw_point.y <= max_bounding_box.y; ++draw_point.y)
+        return false;
+    }
+
+    // Same snapping as rasterize: a zero area makes every barycentric coordinate test fail
+    const Vector3i vertex0 = cast<int>(vertices[0]);
+    const Vector3i edge1 = cast<int>(vertices[1]) - vertex0;
+    const Vector3i edge2 = cast<int>(vertices[2]) - vertex0;
+    return edge1.x * edge2.y - edge2.x * edge1.y != 0;
+}
+
+#ifdef TINY_RENDERER_PROFILING
+// Count the triangle as culled, or rasterized and possibly clipped, the way triangle setup classifies it
+static void count_triangle(const std::array<Vector3f, 3>& vertices, Vector2i dimensions, Vector2i origin)
+{
+    if (!covers_pixels(vertices, dimensions, origin))
+    {
+        PROFILE_COUNT(TrianglesCulled, 1);
+        return;
+    }
+
+    PROFILE_COUNT(TrianglesRasterized, 1);
+    const auto inside = [origin, dimensions](const Vector3f& vertex)
+    {
+        return vertex.x >= origin.x && vertex.y >= origin.y && vertex.x <= origin.x + dimensions.x - 1.0f &&
+               vertex.y <= origin.y + dimensions.y - 1.0f;
+    };
+    PROFILE_COUNT(TrianglesClipped, !(inside(vertices[0]) && inside(vertices[1]) && inside(vertices[2])));
+}
+#endif
+
+void rasterize(const std::array<Vector3f, 3>& vertices, Shader& shader, RenderContext& context)
+{
+    const auto bounding_box = clipped_bounding_box(vertices, Vector2i{0, 0}, Vector2i{context.width(), context.height()});
+    context.touch(bounding_box[0], bounding_box[1]);
+    rasterize(vertices, shader, context.color(), context.depth(), Vector2i{0, 0}, context.debug_targets());
+}
+
+/*
+Scan the bounding box of the triangle in 2x2 quads aligned on even screen coordinates, shading every quad
+with a live pixel at once; Debug adds the cost of each fragment to debug_targets
+*/
+template<bool Debug>
+static void rasterize_triangle(const std::array<Vector3f, 3>& vertices, Shader& shader, TGAImage& image, DepthBuffer& depth_buffer,
+                               Vector2i origin, DebugTargets* debug_targets)
+{
+    const auto bounding_box = clipped_bounding_box(vertices, origin, Vector2i{image.get_width(), image.get_height()});
+    const Vector2i min_bounding_box = bounding_box[0];
+    const Vector2i max_bounding_box = bounding_box[1];
+    const std::array<Vector3i, 3> snapped_vertices{cast<int>(vertices[0]), cast<int>(vertices[1]), cast<int>(vertices[2])};
+    const Vector3f vertex_depths{vertices[0].z, vertices[1].z, vertices[2].z};
+
+    FragmentQuad quad;
+    std::array<int, 4> indices;
+    std::array<float, 4> z_coords;
+    for (quad.origin.x = min_bounding_box.x & ~1; quad.origin.x <= max_bounding_box.x; quad.origin.x += 2)
+    {
+        for (quad.origin.y = min_bounding_box.y & ~1; quad.origin.y <= max_bounding_box.y; quad.origin.y += 2)
         {
-            const auto barycentric = barycentric_coordinates({cast<int>(vertices[0]), cast<int>(vertices[1]), cast<int>(vertices[2])},
-                                                              draw_point);
-            
-            if (barycentric.x < 0 || barycentric.y < 0 || barycentric.z < 0)
+            int live_lanes = 0;
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                const Vector3i draw_point{quad.origin.x + lane % 2, quad.origin.y + lane / 2, 0};
+                const auto barycentric = barycentric_coordinates(snapped_vertices, draw_point);
+                quad.barycentric_coordinates[lane] = barycentric;
+                quad.live[lane] = false;
+
+                // The lanes outside of the clipped bounding box are helper lanes even when covered
+                if (draw_point.x < min_bounding_box.x || draw_point.x > max_bounding_box.x || draw_point.y < min_bounding_box.y ||
+                    draw_point.y > max_bounding_box.y || barycentric.x < 0 || barycentric.y < 0 || barycentric.z < 0)
+                {
+                    continue;
+                }
+
+                z_coords[lane] = float(dot(barycentric, vertex_depths));
+                indices[lane] = static_cast<int>((draw_point.x - origin.x) + (draw_point.y - origin.y) * image.get_width());
+                PROFILE_COUNT(FragmentsTested, 1);
+                if constexpr (Debug)
+                {
+                    ++debug_targets->depth_tests[indices[lane]];
+                }
+
+                if (depth_buffer[indices[lane]] < z_coords[lane])
+                {
+                    PROFILE_COUNT(FragmentsPassed, 1);
+                    quad.live[lane] = true;
+                    ++live_lanes;
+                }
+            }
+
+            if (live_lanes == 0)
             {
                 continue;
             }
 
-            auto z_coord = float(dot(barycentric, Vector3f{vertices[0].z, vertices[1].z, vertices[2].z}));
+            PROFILE_COUNT(HelperLanes, 4 - live_lanes);
+            std::array<TGAColor, 4> colors;
+            std::array<bool, 4> discarded{};
+            {
+                PROFILE_STAGE(FragmentShading);
+                if constexpr (Debug)
+                {
+                    // The cost of the quad is split between its live lanes
+                    const std::uint64_t start = debug_cycle_counter();
+                    shader.fragment_quad(quad, colors, discarded);
+                    const std::uint64_t cycles = (debug_cycle_counter() - start) / live_lanes;
+                    for (int lane = 0; lane < 4; ++lane)
+                    {
+                        if (quad.live[lane])
+                        {
+                            debug_targets->shader_cycles[indices[lane]] += cycles;
+                            ++debug_targets->shader_invocations[indices[lane]];
+                        }
+                    }
+                }
+                else
+                {
+                    shader.fragment_quad(quad, colors, discarded);
+                }
+            }
 
-            const int index = static_cast<int>(draw_point.x + draw_point.y * image.get_width());
-            
-            if (depth_buffer[index] < z_coord)
+            float footprint = 0.0f;
+            if constexpr (Debug)
+            {
+                footprint = shader.texture_footprint(quad);
+            }
+
+            for (int lane = 0; lane < 4; ++lane)
             {
-                TGAColor color;
-                bool discard = shader.fragment(barycentric, color);
-                if (!discard)
+                if (quad.live[lane] && !discarded[lane])
                 {
-                    depth_buffer[index] = z_coord;
-                    image.set(draw_point.x, draw_point.y, color);
+                    PROFILE_COUNT(FragmentsShaded, 1);
+                    depth_buffer[indices[lane]] = z_coords[lane];
+                    if constexpr (Debug)
+                    {
+                        debug_targets->texel_footprint[indices[lane]] = footprint;
+                    }
+                    image.set(quad.origin.x + lane % 2 - origin.x, quad.origin.y + lane / 2 - origin.y, colors[lane]);
                 }
             }
         }
-    }   
-}
\ No newline at end of file
+    }
+}
+
+void rasterize(const std::array<Vector3f, 3>& vertices, Shader& shader, TGAImage& image, DepthBuffer& depth_buffer, Vector2i origin,
+               DebugTargets* debug_targets)
+{
+    PROFILE_STAGE(Rasterization);
+#ifdef TINY_RENDERER_PROFILING
+    count_triangle(vertices, Vector2i{image.get_width(), image.get_height()}, origin);
+#endif
+
+    if (debug_targets != nullptr)
+    {
+        rasterize_triangle<true>(vertices, shader, image, depth_buffer, origin, debug_targets);
+    }
+    else
+    {
+        rasterize_triangle<false>(vertices, shader, image, depth_buffer, origin, nullptr);
+    }
+}
@@ -1,9 +1,11 @@
 #ifndef RENDERING_HPP
 #define RENDERING_HPP
 
+#include "rendercontext.hpp"
 #include "tgaimage.h"
 #include "vector.hpp"
 #include <array>
+#include <limits>
 #include <vector>
 
 class TriangleMesh;
@@ -15,22 +17,37 @@ void draw_line(Vector2i start, Vector2i end, TGAImage& image, TGAColor color);
 // Draw a filled triangle using the Line Sweeping algorithm using the provided color
 void line_sweeping_fill_triangle(Vector2i vertex0, Vector2i vertex1, Vector2i vertex2, TGAImage& image, const TGAColor& color);
 
-// Draw a filled triangle using the Bounding Box algorithm using the provided color
-void fill_colored_triangle(Vector2i vertex0, Vector2i vertex1, Vector2i vertex2, TGAImage& image, const TGAColor& color);
+// Draw a filled triangle using the Bounding Box algorithm using the provided color, only on the rows [first_row; last_row[
+void fill_colored_triangle(Vector2i vertex0, Vector2i vertex1, Vector2i vertex2, TGAImage& image, const TGAColor& color,
+                           int first_row = 0, int last_row = std::numeric_limits<int>::max());
 
 // Draw a filled triangle using the Bounding Box algorithm and depth buffering using the provided color
-void fill_colored_triangle(Vector3i vertex0, Vector3i vertex1, Vector3i vertex2, std::vector<float>& depth_buffer, TGAImage& image, const TGAColor& color);
+void fill_colored_triangle(Vector3i vertex0, Vector3i vertex1, Vector3i vertex2, DepthBuffer& depth_buffer, TGAImage& image, const TGAColor& color);
 
 // Draw a filled triangle using the Bounding Box algorithm and depth buffering using an image texture
-void fill_textured_triangle(const std::array<Vector3i, 3>& vertices, const std::array<Vector2f, 3>& uv_coordinates, const TriangleMesh& model, std::vector<float>& depth_buffer, TGAImage& image);
+void fill_textured_triangle(const std::array<Vector3i, 3>& vertices, const std::array<Vector2f, 3>& uv_coordinates, const TriangleMesh& model, DepthBuffer& depth_buffer, TGAImage& image);
 
 // Draw a filled triangle using the Bounding Box algorithm and depth buffering using an image texture
-void fill_textured_triangle(const std::array<Vector3i, 3>& vertices, const std::array<Vector2f, 3>& uv_coordinates, float light_intensity, const TriangleMesh& model, std::vector<float>& depth_buffer, TGAImage& image);
+void fill_textured_triangle(const std::array<Vector3i, 3>& vertices, const std::array<Vector2f, 3>& uv_coordinates, float light_intensity, const TriangleMesh& model, DepthBuffer& depth_buffer, TGAImage& image);
 
 // Draw triangle using Gouraud shading
-void fill_triangle_gouraud(const std::array<Vector3i, 3>& vertices, const std::array<float, 3>& intensities, std::vector<float>& depth_buffer, TGAImage& image);
-
-// Final rasterization function, used to render Our GL
-void rasterize(const std::array<Vector3f, 3>& vertices, Shader& shader, TGAImage& image, std::vector<float>& depth_buffer);
+void fill_triangle_gouraud(const std::array<Vector3i, 3>& vertices, const std::array<float, 3>& intensities, DepthBuffer& depth_buffer, TGAImage& image);
+
+/*
+Final rasterization function, used to render Our GL. The image and depth buffer cover the screen
+rectangle that starts at origin, which allows to render a large image one tile at a time. The
+fragment costs are added to debug_targets if given, which must have the size of the image
+*/
+void rasterize(const std::array<Vector3f, 3>& vertices, Shader& shader, TGAImage& image, DepthBuffer& depth_buffer, 
+               Vector2i origin = Vector2i{0, 0}, DebugTargets* debug_targets = nullptr);
+
+// Rasterize into the targets of the context, applying the pending clears of the tiles touched by the triangle first
+void rasterize(const std::array<Vector3f, 3>& vertices, Shader& shader, RenderContext& context);
+
+/*
+Triangle setup: false if rasterize cannot draw any pixel of the triangle on the screen rectangle of size dimensions
+that starts at origin, i.e. the triangle is outside of it or degenerate once its vertices are snapped to pixels
+*/
+bool covers_pixels(const std::array<Vector3f, 3>& vertices, Vector2i dimensions, Vector2i origin = Vector2i{0, 0});
 
 #endif // RENDERING_HPP
\ No newline at end of file
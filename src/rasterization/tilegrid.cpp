@@ -0,0 +1,96 @@
+#include "tilegrid.hpp"
+#include <algorithm>
+#include <cmath>
+
+TileGrid::TileGrid(int width, int height, int tile_size, FrameArena& arena): 
+    width_{width}, height_{height}, tile_size_{tile_size}, 
+    tiles_x_{(width + tile_size - 1) / tile_size}, tiles_y_{(height + tile_size - 1) / tile_size},
+    bins_{arena.allocate<Bin>(tiles_x_ * tiles_y_)}
+{
+    std::fill(bins_, bins_ + tiles_x_ * tiles_y_, Bin{nullptr, nullptr});
+}
+
+int TileGrid::tile_size() const
+{
+    return tile_size_;
+}
+
+int TileGrid::number_tiles_x() const
+{
+    return tiles_x_;
+}
+
+int TileGrid::number_tiles_y() const
+{
+    return tiles_y_;
+}
+
+Vector2i TileGrid::tile_origin(int tile_x, int tile_y) const
+{
+    return Vector2i{tile_x * tile_size_, tile_y * tile_size_};
+}
+
+Vector2i TileGrid::tile_dimensions(int tile_x, int tile_y) const
+{
+    const auto origin = tile_origin(tile_x, tile_y);
+    return Vector2i{std::min(tile_size_, width_ - origin.x), std::min(tile_size_, height_ - origin.y)};
+}
+
+void TileGrid::insert(int triangle, const std::array<Vector3f, 3>& vertices, FrameArena& arena)
+{
+    // Same bounding box as the rasterizer, in tile units
+    const float min_x = std::min(std::min(vertices[0].x, vertices[1].x), vertices[2].x);
+    const float min_y = std::min(std::min(vertices[0].y, vertices[1].y), vertices[2].y);
+    const float max_x = std::max(std::max(vertices[0].x, vertices[1].x), vertices[2].x);
+    const float max_y = std::max(std::max(vertices[0].y, vertices[1].y), vertices[2].y);
+
+    // Coordinates are truncated by the rasterizer, so e.g. max_x = -0.5 still covers the first column
+    if (max_x <= -1.0f || max_y <= -1.0f || min_x >= width_ || min_y >= height_)
+    {
+        return;
+    }
+
+    const int first_tile_x = static_cast<int>(std::max(0.0f, min_x)) / tile_size_;
+    const int first_tile_y = static_cast<int>(std::max(0.0f, min_y)) / tile_size_;
+    const int last_tile_x = static_cast<int>(std::min(width_ - 1.0f, max_x)) / tile_size_;
+    const int last_tile_y = static_cast<int>(std::min(height_ - 1.0f, max_y)) / tile_size_;
+
+    for (int tile_y = first_tile_y; tile_y <= last_tile_y; ++tile_y)
+    {
+        for (int tile_x = first_tile_x; tile_x <= last_tile_x; ++tile_x)
+        {
+            auto& bin = bins_[tile_x + tile_y * tiles_x_];
+            if (bin.last == nullptr || bin.last->size == TileBinChunk::capacity)
+            {
+                auto* chunk = arena.allocate<TileBinChunk>(1);
+                chunk->next = nullptr;
+                chunk->size = 0;
+                (bin.last == nullptr ? bin.first : bin.last->next) = chunk;
+                bin.last = chunk;
+            }
+            bin.last->triangles[bin.last->size++] = triangle;
+        }
+    }
+}
+
+TileBin TileGrid::triangles(int tile_x, int tile_y) const
+{
+    return TileBin{bins_[tile_x + tile_y * tiles_x_].first};
+}
+
+void TileGrid::append(TileGrid& other)
+{
+    for (int i = 0; i < tiles_x_ * tiles_y_; ++i)
+    {
+        auto& bin = bins_[i];
+        auto& other_bin = other.bins_[i];
+        if (other_bin.first == nullptr)
+        {
+            continue;
+        }
+
+        (bin.last == nullptr ? bin.first : bin.last->next) = other_bin.first;
+        bin.last = other_bin.last;
+        other_bin = Bin{nullptr, nullptr};
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef TILE_GRID_HPP
+#define TILE_GRID_HPP
+
+#include "framearena.hpp"
+#include "vector.hpp"
+#include <array>
+
+// Triangles of a tile, in chunks chained in insertion order
+struct TileBinChunk
+{
+    static constexpr int capacity = 62; // 256 bytes per chunk
+    TileBinChunk* next;
+    int size;
+    int triangles[capacity];
+};
+
+// Forward range over the triangles of a tile
+class TileBin
+{
+public:
+    class Iterator
+    {
+    public:
+        Iterator(const TileBinChunk* chunk, int index): chunk_{chunk}, index_{index} {}
+        int operator*() const { return chunk_->triangles[index_]; }
+        Iterator& operator++()
+        {
+            if (++index_ == chunk_->size)
+            {
+                chunk_ = chunk_->next;
+                index_ = 0;
+            }
+            return *this;
+        }
+        bool operator!=(const Iterator& other) const { return chunk_ != other.chunk_ || index_ != other.index_; }
+    private:
+        const TileBinChunk* chunk_;
+        int index_;
+    };
+
+    explicit TileBin(const TileBinChunk* first): first_{first} {}
+    Iterator begin() const { return Iterator{first_, 0}; }
+    Iterator end() const { return Iterator{nullptr, 0}; }
+private:
+    const TileBinChunk* first_;
+};
+
+/*
+Spatial index for tiled rendering: uniform grid over the screen that stores, for each tile,
+the triangles whose screen space bounding box overlaps it. The bins are per-frame data allocated
+from frame arenas, which must outlive the grid until they are reset; the grid itself holds no
+other memory and is trivially destructible, so it can be allocated from an arena as well.
+*/
+class TileGrid
+{
+public:
+    // The heads of the bins are allocated from arena
+    TileGrid(int width, int height, int tile_size, FrameArena& arena);
+    int tile_size() const;
+    int number_tiles_x() const;
+    int number_tiles_y() const;
+
+    // Screen rectangle covered by the tile, clamped to the screen
+    Vector2i tile_origin(int tile_x, int tile_y) const;
+    Vector2i tile_dimensions(int tile_x, int tile_y) const;
+
+    // The chunks are allocated from arena, e.g. the arena of the calling thread when binning in parallel
+    void insert(int triangle, const std::array<Vector3f, 3>& vertices, FrameArena& arena);
+
+    // Move the bins of a grid with the same dimensions, e.g. filled with a later range of triangles, after the bins of this one; O(number of tiles)
+    void append(TileGrid& other);
+    TileBin triangles(int tile_x, int tile_y) const;
+private:
+    struct Bin
+    {
+        TileBinChunk* first;
+        TileBinChunk* last;
+    };
+
+    int width_;
+    int height_;
+    int tile_size_;
+    int tiles_x_;
+    int tiles_y_;
+    Bin* bins_;
+};
+
+#endif // TILE_GRID_HPP
@@ -0,0 +1,151 @@
+#include "pipeline.hpp"
+#include "jobsystem.hpp"
+#include "profiler.hpp"
+#include "rendering.hpp"
+#include <algorithm>
+#include <array>
+#include <new>
+
+// Triangle passed from the vertex stage to the rasterizer
+struct PipelineTriangle
+{
+    std::array<Vector3f, 3> vertices; // screen coordinates
+    Varyings varyings;
+    bool visible; // kept by triangle setup
+};
+
+// Inputs of the vertex stage shared by the batches of a frame
+struct PipelineFrame
+{
+    const TriangleMesh* model;
+    const RenderSettings* settings;
+    int width;
+    int height;
+};
+
+// Slot of the window of batches in flight, reused by every window-th batch
+struct PipelineBatch
+{
+    JobCounter shaded;
+    PipelineTriangle* triangles;
+    int first_face; // of the batch using the slot
+    int last_face;
+};
+
+// Vertex shading and triangle setup of the faces [first_face, last_face) of the batch
+static void shade_batch(const PipelineFrame& frame, const PipelineBatch& batch)
+{
+    const int width = frame.width;
+    const int height = frame.height;
+    auto shader = make_shader(*frame.model, *frame.settings, width, height);
+    for (int face = batch.first_face; face < batch.last_face; ++face)
+    {
+        auto& triangle = batch.triangles[face - batch.first_face];
+        {
+            PROFILE_STAGE(VertexShading);
+            for (int j = 0; j < 3; ++j)
+            {
+                triangle.vertices[j] = shader->vertex(face, j);
+            }
+            shader->save_varyings(triangle.varyings);
+        }
+        {
+            PROFILE_STAGE(Setup);
+            triangle.visible = covers_pixels(triangle.vertices, Vector2i{width, height});
+        }
+        PROFILE_COUNT(TrianglesCulled, !triangle.visible);
+    }
+}
+
+void render_pipelined(const TriangleMesh& model, const RenderSettings& settings, RenderContext& context,
+                      const PipelineOptions& options)
+{
+    const int width = context.width();
+    const int height = context.height();
+    const int number_faces = model.number_faces();
+    if (number_faces == 0)
+    {
+        context.resolve();
+        return;
+    }
+
+    const int batch_size = std::max(1, options.batch_size);
+    const int number_batches = (number_faces + batch_size - 1) / batch_size;
+    JobSystem* job_system = options.job_system;
+
+    int batches_in_flight = options.batches_in_flight;
+    if (batches_in_flight <= 0)
+    {
+        batches_in_flight = job_system != nullptr ? 2 * job_system->number_threads() : 1;
+    }
+    batches_in_flight = std::max(1, std::min(batches_in_flight, number_batches));
+
+    /*
+    The window lives in the frame arena and a job only captures two pointers, so that its function is
+    stored inline; each batch still allocates its job and its shader
+    */
+    const PipelineFrame frame{&model, &settings, width, height};
+    auto* batches = context.arena().allocate<PipelineBatch>(batches_in_flight);
+    for (int i = 0; i < batches_in_flight; ++i)
+    {
+        new (&batches[i]) PipelineBatch{};
+        batches[i].triangles = context.arena().allocate<PipelineTriangle>(batch_size);
+    }
+
+    const auto submit_batch = [&](int batch)
+    {
+        PipelineBatch* slot = &batches[batch % batches_in_flight];
+        slot->first_face = batch * batch_size;
+        slot->last_face = std::min(number_faces, slot->first_face + batch_size);
+        if (job_system == nullptr)
+        {
+            shade_batch(frame, *slot);
+            return;
+        }
+
+        const PipelineFrame* frame_inputs = &frame;
+        job_system->submit([frame_inputs, slot]() { shade_batch(*frame_inputs, *slot); }, &slot->shaded);
+    };
+
+    for (int batch = 0; batch < batches_in_flight; ++batch)
+    {
+        submit_batch(batch);
+    }
+
+    // Raster stage: taking the batches in order keeps the draw order, hence the depth test ties, of render
+    PROFILE_COUNT(TrianglesIn, number_faces);
+    auto shader = make_shader(model, settings, width, height);
+    PROFILE_SCOPE("pipeline_rasterization");
+    for (int batch = 0; batch < number_batches; ++batch)
+    {
+        auto& slot = batches[batch % batches_in_flight];
+        if (job_system != nullptr)
+        {
+            job_system->wait(slot.shaded);
+        }
+        else if (batch >= batches_in_flight)
+        {
+            submit_batch(batch);
+        }
+
+        const int batch_faces = std::min(batch_size, number_faces - batch * batch_size);
+        for (int i = 0; i < batch_faces; ++i)
+        {
+            const auto& triangle = slot.triangles[i];
+            if (triangle.visible)
+            {
+                shader->load_varyings(triangle.varyings);
+                rasterize(triangle.vertices, *shader, context);
+            }
+        }
+
+        // The slot is free again: shade the batch that reuses it
+        if (job_system != nullptr && batch + batches_in_flight < number_batches)
+        {
+            submit_batch(batch + batches_in_flight);
+        }
+    }
+
+    context.resolve();
+    PROFILE_COUNT(PixelsCovered, covered_pixels(context.depth()));
+}
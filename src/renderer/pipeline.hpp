@@ -0,0 +1,27 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include "renderer.hpp"
+
+class JobSystem;
+
+struct PipelineOptions
+{
+    JobSystem* job_system{nullptr}; // runs the vertex stage; without one, the calling thread shades each batch before rasterizing it
+    int batch_size{256}; // consecutive faces vertex shaded by one job
+    int batches_in_flight{0}; // batches shaded ahead of the rasterizer, which bounds the memory; <= 0 uses two per worker
+};
+
+/*
+Streaming version of render(model, settings, context), with the stages overlapped instead of one after the other:
+- jobs of the job system vertex shade the faces in batches and drop the triangles that cannot cover a pixel
+  (triangle setup), storing the screen space triangles with their varyings;
+- the calling thread rasterizes the batches in face order as they are finished, running other jobs while it
+  waits for one, and keeps a bounded window of batches submitted ahead.
+No thread is created and nothing spins, so it can run within a job, e.g. concurrently with other scenes.
+The first pixels are drawn while most of the mesh is still being vertex shaded, and the image is the same as render's.
+*/
+void render_pipelined(const TriangleMesh& model, const RenderSettings& settings, RenderContext& context,
+                      const PipelineOptions& options = PipelineOptions{});
+
+#endif // PIPELINE_HPP
@@ -0,0 +1,109 @@
+#include "renderer.hpp"
+#include "profiler.hpp"
+#include "rendering.hpp"
+#include "transform.hpp"
+#include <algorithm>
+#include <array>
+#include <limits>
+
+AnyShader make_shader(ShadersOptions shader_choice, const TriangleMesh& model, const Matrix& model_view_projection,
+                      const Matrix& viewport_transform, const Vector3f& light_direction)
+{
+    if (shader_choice == ShadersOptions::Gouraud)
+    {
+        return AnyShader{std::in_place_type<Gouraud>, model, model_view_projection, viewport_transform, light_direction};
+    }
+    else if (shader_choice == ShadersOptions::BasicTexture)
+    {
+        return AnyShader{std::in_place_type<BasicTexture>, model, model_view_projection, viewport_transform, light_direction};
+    }
+    else if (shader_choice == ShadersOptions::NormalMappingTexture)
+    {
+        return AnyShader{std::in_place_type<Texture>, model, model_view_projection, viewport_transform, light_direction};
+    }
+    
+    return AnyShader{std::in_place_type<Phong>, model, model_view_projection, viewport_transform, light_direction};
+}
+
+AnyShader make_shader(const TriangleMesh& model, const RenderSettings& settings, int width, int height)
+{
+    const auto& camera = settings.camera;
+    const auto view_matrix = look_at(camera.eye, camera.center, camera.up);
+    const auto projection_matrix = projection(float((camera.eye - camera.center).length()));
+    const auto viewport_matrix = viewport(width / 8, height / 8, width * 3 / 4, height * 3 / 4, settings.depth);
+    
+    return make_shader(settings.shader, model, projection_matrix * view_matrix, viewport_matrix, unit_vector(settings.light_direction));
+}
+
+std::string shader_name(ShadersOptions shader_choice)
+{
+    if (shader_choice == ShadersOptions::Gouraud)
+    {
+        return "gouraud";
+    }
+    else if (shader_choice == ShadersOptions::BasicTexture)
+    {
+        return "basic_texture";
+    }
+    else if (shader_choice == ShadersOptions::NormalMappingTexture)
+    {
+        return "normal_mapping";
+    }
+
+    return "phong";
+}
+
+void render(const TriangleMesh& model, const RenderSettings& settings, TGAImage& color, DepthBuffer* depth)
+{
+    const int width = color.get_width();
+    const int height = color.get_height();
+    DepthBuffer scratch_depth;
+    auto& depth_buffer = (depth != nullptr ? *depth : scratch_depth);
+    depth_buffer.assign(width * height, std::numeric_limits<float>::lowest());
+
+    auto shader = make_shader(model, settings, width, height);
+    PROFILE_COUNT(TrianglesIn, model.number_faces());
+    for (int i = 0; i < model.number_faces(); ++i)
+    {
+        std::array<Vector3f, 3> screen_coordinates;
+        {
+            PROFILE_STAGE(VertexShading);
+            for (int j = 0; j < 3; ++j)
+            {
+                screen_coordinates[j] = shader->vertex(i, j);
+            }
+        }
+        
+        rasterize(screen_coordinates, *shader, color, depth_buffer);
+    }
+    PROFILE_COUNT(PixelsCovered, covered_pixels(depth_buffer));
+}
+
+void render(const TriangleMesh& model, const RenderSettings& settings, RenderContext& context)
+{
+    auto shader = make_shader(model, settings, context.width(), context.height());
+    PROFILE_COUNT(TrianglesIn, model.number_faces());
+    for (int i = 0; i < model.number_faces(); ++i)
+    {
+        std::array<Vector3f, 3> screen_coordinates;
+        {
+            PROFILE_STAGE(VertexShading);
+            for (int j = 0; j < 3; ++j)
+            {
+                screen_coordinates[j] = shader->vertex(i, j);
+            }
+        }
+        
+        rasterize(screen_coordinates, *shader, context);
+    }
+
+    context.resolve();
+    PROFILE_COUNT(PixelsCovered, covered_pixels(context.depth()));
+}
+
+FrameBuffer render(const TriangleMesh& model, const RenderSettings& settings, int width, int height, bool keep_depth)
+{
+    FrameBuffer frame{TGAImage{width, height, TGAImage::RGB}, {}};
+    render(model, settings, frame.color, keep_depth ? &frame.depth : nullptr);
+    return frame;
+}
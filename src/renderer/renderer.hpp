@@ -0,0 +1,97 @@
+#ifndef RENDERER_HPP
+#define RENDERER_HPP
+
+#include "basictextureshader.hpp"
+#include "gouraudshader.hpp"
+#include "matrix.hpp"
+#include "phongshader.hpp"
+#include "rendercontext.hpp"
+#include "shader.hpp"
+#include "textureshader.hpp"
+#include "tgaimage.h"
+#include "trianglemesh.hpp"
+#include "vector.hpp"
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// List of available shaders
+enum class ShadersOptions
+{
+    Gouraud,
+    BasicTexture,
+    NormalMappingTexture,
+    Phong
+};
+
+struct Camera
+{
+    Vector3f eye{1, 1, 3};
+    Vector3f center{0, 0, 0};
+    Vector3f up{0, 1, 0};
+};
+
+struct RenderSettings
+{
+    Camera camera;
+    Vector3f light_direction{1, 1, 1}; // normalized by the renderer
+    ShadersOptions shader{ShadersOptions::NormalMappingTexture};
+    int depth{255}; // depth range of the viewport
+};
+
+// Color image (origin on the bottom left corner) and depth buffer (empty unless requested) owned by the caller
+struct FrameBuffer
+{
+    TGAImage color;
+    DepthBuffer depth;
+};
+
+/*
+One of the shaders of Our GL, held inline rather than on the heap so that creating the shader of a frame
+does not allocate. Used like a pointer to the Shader; it cannot be moved, which keeps the pointer valid
+*/
+class AnyShader
+{
+public:
+    template<typename T, typename... Args>
+    explicit AnyShader(std::in_place_type_t<T> type, Args&&... args):
+        storage_{type, std::forward<Args>(args)...}, shader_{&std::get<T>(storage_)}
+    {}
+    AnyShader(const AnyShader&) = delete;
+    AnyShader& operator=(const AnyShader&) = delete;
+
+    Shader& operator*() const { return *shader_; }
+    Shader* operator->() const { return shader_; }
+private:
+    std::variant<Gouraud, BasicTexture, Texture, Phong> storage_;
+    Shader* shader_;
+};
+
+// Create the shader used by Our GL for the given choice
+AnyShader make_shader(ShadersOptions shader_choice, const TriangleMesh& model, const Matrix& model_view_projection,
+                      const Matrix& viewport_transform, const Vector3f& light_direction);
+
+// Create the shader for the settings, with the viewport covering the center of a width x height image
+AnyShader make_shader(const TriangleMesh& model, const RenderSettings& settings, int width, int height);
+
+// Name of the shader, used on the output files
+std::string shader_name(ShadersOptions shader_choice);
+
+/*
+Render the model into caller-provided buffers. The model is drawn over the current content of color,
+whose size sets the output size. If depth is given it is resized to width * height, cleared and left
+holding the depth of the frame; otherwise a temporary depth buffer is used.
+*/
+void render(const TriangleMesh& model, const RenderSettings& settings, TGAImage& color, DepthBuffer* depth = nullptr);
+
+/*
+Render the model into the targets of a context reused across frames. Tiles flagged by context.clear() are
+cleared when first touched and the remaining ones at the end, so the targets are complete on return
+*/
+void render(const TriangleMesh& model, const RenderSettings& settings, RenderContext& context);
+
+// Render the model into newly allocated buffers, handed over to the caller without copies
+FrameBuffer render(const TriangleMesh& model, const RenderSettings& settings, int width, int height, bool keep_depth = false);
+
+#endif // RENDERER_HPP
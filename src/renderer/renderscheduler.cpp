@@ -0,0 +1,57 @@
+#include "renderscheduler.hpp"
+
+RenderScheduler::RenderScheduler(JobSystem& job_system, int width, int height, int max_jobs_in_flight): 
+    job_system_{job_system}, width_{width}, height_{height},
+    max_jobs_in_flight_{max_jobs_in_flight > 0 ? max_jobs_in_flight : job_system.number_threads() + 1}
+{}
+
+void RenderScheduler::submit(std::function<void(RenderContext&)> job)
+{
+    {
+        // A job must not block: the jobs it waits for could be below it on its own thread
+        std::unique_lock<std::mutex> lock{mutex_};
+        if (!JobSystem::running_job())
+        {
+            job_finished_.wait(lock, [this]() { return jobs_in_flight_ < max_jobs_in_flight_; });
+        }
+        ++jobs_in_flight_;
+    }
+
+    job_system_.submit([this, job = std::move(job)]()
+    {
+        auto context = acquire_context();
+        job(*context);
+        release_context(std::move(context));
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            --jobs_in_flight_;
+        }
+        job_finished_.notify_all();
+    }, &jobs_);
+}
+
+void RenderScheduler::wait()
+{
+    job_system_.wait(jobs_);
+}
+
+std::unique_ptr<RenderContext> RenderScheduler::acquire_context()
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        if (!free_contexts_.empty())
+        {
+            auto context = std::move(free_contexts_.back());
+            free_contexts_.pop_back();
+            return context;
+        }
+    }
+
+    return std::make_unique<RenderContext>(width_, height_);
+}
+
+void RenderScheduler::release_context(std::unique_ptr<RenderContext> context)
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    free_contexts_.push_back(std::move(context));
+}
@@ -0,0 +1,45 @@
+#ifndef RENDER_SCHEDULER_HPP
+#define RENDER_SCHEDULER_HPP
+
+#include "jobsystem.hpp"
+#include "rendercontext.hpp"
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/*
+Runs independent render jobs (e.g. scenes or views of a shared read-only model) concurrently on a
+job system. Each job borrows a render context for its duration, so jobs never share a render target
+and contexts are reused from one job to the next. Contexts are borrowed rather than tied to threads
+because a job waiting for its own children may run another render job on the same thread.
+submit blocks the calling thread (outside of a job) while max_jobs_in_flight jobs are unfinished,
+which applies back-pressure to the submitter, e.g. to bound the frames held by the render jobs.
+*/
+class RenderScheduler
+{
+public:
+    // max_jobs_in_flight <= 0 allows one job per worker of the job system, plus one for the waiting thread
+    RenderScheduler(JobSystem& job_system, int width, int height, int max_jobs_in_flight = 0);
+
+    void submit(std::function<void(RenderContext&)> job);
+
+    // Block until every submitted job is finished; the calling thread runs jobs in the meantime
+    void wait();
+private:
+    std::unique_ptr<RenderContext> acquire_context();
+    void release_context(std::unique_ptr<RenderContext> context);
+
+    JobSystem& job_system_;
+    JobCounter jobs_;
+    const int width_;
+    const int height_;
+    const int max_jobs_in_flight_;
+    std::mutex mutex_; // protects the free contexts and the jobs in flight
+    std::condition_variable job_finished_;
+    int jobs_in_flight_{0};
+    std::vector<std::unique_ptr<RenderContext>> free_contexts_;
+};
+
+#endif // RENDER_SCHEDULER_HPP
@@ -1,17 +1,24 @@
-#include "basictextureshader.hpp"
 #include "scenes.hpp"
-#include "gouraudshader.hpp"
 #include "matrix.hpp"
-#include "phongshader.hpp"
+#include "debugtargets.hpp"
+#include "pipeline.hpp"
+#include "profiler.hpp"
 #include "rendering.hpp"
-#include "textureshader.hpp"
+#include "tilegrid.hpp"
 #include "transform.hpp"
+#include "trianglestream.hpp"
 #include "random.hpp"
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstdio>
+#include <iostream>
 #include <limits>
 #include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 Vector3i world_to_screen(Vector3f pos, int width, int height)
@@ -19,13 +26,136 @@ Vector3i world_to_screen(Vector3f pos, int width, int height)
     return Vector3i{int((pos.x + 1.0f) * width / 2.0f), int((pos.y + 1.0f) * height / 2.0f), int((pos.z + 1.0) * 255 / 2.0f)};
 }
 
-Scenes::Scenes(const std::string& filename, int image_width, int image_height): 
-    model{filename}, model_name{parse_filename(filename)}, width{image_width}, height{image_height}, 
-    image{image_width, image_height, TGAImage::RGB}
+const Vector3i* transform_vertices(const TriangleMesh& model, const Matrix& transform, FrameArena& arena, JobSystem* job_system)
+{
+    Vector3i* screen_vertices = arena.allocate<Vector3i>(model.number_vertices());
+    parallel_for(job_system, 0, model.number_vertices(), 4096, [&](int first, int last)
+    {
+        for (int i = first; i < last; ++i)
+        {
+            screen_vertices[i] = cast<int>(homogeneous_to_cartesian(transform * cartesian_to_homogeneous(model.vertex(i))));
+        }
+    });
+
+    return screen_vertices;
+}
+
+// One frame per thread rendering (the workers and the thread waiting for them, see RenderScheduler), plus one being written
+static int frames_in_flight(const JobSystem* job_system)
+{
+    const int threads = job_system != nullptr ? job_system->number_threads() : static_cast<int>(std::thread::hardware_concurrency());
+    return std::max(1, threads) + 2;
+}
+
+Scenes::Scenes(const std::string& filename, const MeshLoadOptions& mesh_options, int image_width, int image_height, 
+               JobSystem* job_system): 
+    job_system{job_system}, frame_writer{frames_in_flight(job_system), job_system},
+    model{filename, mesh_options}, model_name{parse_filename(filename)}, width{image_width}, height{image_height}
+{}
+
+Scenes::Scenes(TriangleMesh mesh, const std::string& model_name, int image_width, int image_height, JobSystem* job_system):
+    job_system{job_system}, frame_writer{frames_in_flight(job_system), job_system},
+    model{std::move(mesh)}, model_name{model_name}, width{image_width}, height{image_height}
 {}
 
-void Scenes::draw_wire_mesh()
+bool Scenes::wait_for_output()
+{
+    return frame_writer.wait();
+}
+
+void Scenes::begin_frame(RenderContext& context)
+{
+    // The previous color target was handed to the frame writer, or is the initial one of the context
+    context.swap_color(frame_writer.acquire_frame(width, height, TGAImage::RGB));
+    // The allocations of the previous frame are dead, also in the scenes which never clear the context
+    context.arena().reset();
+}
+
+DepthBuffer& Scenes::clear_depth_buffer(RenderContext& context)
+{
+    // Frames from the frame writer are already clear, so only the depth is reset
+    context.clear(false);
+    context.resolve();
+    return context.depth();
+}
+
+void Scenes::finish_frame(RenderContext& context, const std::string& output_file)
+{
+    frame_writer.submit(context.swap_color(TGAImage{}), output_directory + output_file, output_format);
+}
+
+void Scenes::set_output_format(ImageFormat format)
+{
+    output_format = format;
+}
+
+void Scenes::set_output_directory(const std::string& directory)
+{
+    output_directory = directory;
+    if (!output_directory.empty() && output_directory.back() != '/' && output_directory.back() != '\\')
+    {
+        output_directory += '/';
+    }
+}
+
+void Scenes::set_pipelined(bool enabled)
+{
+    pipelined = enabled;
+}
+
+void Scenes::set_heatmaps(bool enabled)
 {
+    heatmaps = enabled;
+}
+
+template<typename T>
+void Scenes::write_heatmap_frame(const std::vector<T>& values, const std::string& output_file, const char* unit)
+{
+    // Saturate at the 99th percentile: slivers along the silhouette and preempted fragments are a few extreme pixels
+    TGAImage frame{frame_writer.acquire_frame(width, height, TGAImage::RGB)};
+    const double saturation = write_heatmap(values, frame, 0.99);
+    char red[32];
+    std::snprintf(red, sizeof(red), std::is_floating_point<T>::value ? "%.2f" : "%.0f", saturation);
+    std::cerr << (output_file + ": red is " + red + " " + unit + " or more\n") << std::flush;
+    frame_writer.submit(std::move(frame), output_directory + output_file, output_format);
+}
+
+void Scenes::render_our_gl(const RenderSettings& settings, RenderContext& context, const std::string& output_file)
+{
+    DebugTargets debug_targets;
+    if (heatmaps)
+    {
+        debug_targets.reset(width, height);
+        context.set_debug_targets(&debug_targets);
+    }
+
+    if (pipelined)
+    {
+        PipelineOptions options;
+        options.job_system = job_system;
+        render_pipelined(model, settings, context, options);
+    }
+    else
+    {
+        render(model, settings, context);
+    }
+
+    if (heatmaps)
+    {
+        context.set_debug_targets(nullptr);
+        write_heatmap_frame(debug_targets.depth_tests, output_file + "_depth_tests", "depth tests");
+        write_heatmap_frame(debug_targets.shader_invocations, output_file + "_shader_invocations", "invocations");
+        write_heatmap_frame(debug_targets.shader_cycles, output_file + "_shader_cycles", "cycles");
+        if (std::any_of(debug_targets.texel_footprint.begin(), debug_targets.texel_footprint.end(), [](float texels) { return texels > 0.0f; }))
+        {
+            write_heatmap_frame(debug_targets.texel_footprint, output_file + "_texel_footprint", "texels per pixel");
+        }
+    }
+}
+
+void Scenes::draw_wire_mesh(RenderContext& context)
+{
+    begin_frame(context);
     const TGAColor white{255, 255, 255, 255};
     const TGAColor red{255, 0, 0, 255};
     
@@ -44,41 +174,63 @@ void Scenes::draw_wire_mesh()
             int x1 = static_cast<int>((end.x + 1.0f) * width / 2.0f);
             int y1 = static_cast<int>((end.y + 1.0f) * height / 2.0f);
 
-            draw_line(Vector2i{x0, y0}, Vector2i{x1, y1}, image, white);
+            draw_line(Vector2i{x0, y0}, Vector2i{x1, y1}, context.color(), white);
         }
     }
 
-    image.flip_vertically(); // set origin to left bottom corner
-    const std::string output_file = "1." + model_name + "_wire_mesh.tga";
-    image.write_tga_file(output_file.c_str()); 
-    image.clear();
+    const std::string output_file = "1." + model_name + "_wire_mesh";
+    finish_frame(context, output_file);
 }
 
-void Scenes::draw_random_colored_triangles()
-{    
-    for (int i = 0; i < model.number_faces(); ++i)
+void Scenes::draw_random_colored_triangles(RenderContext& context)
+{
+    begin_frame(context);
+    const int number_faces = model.number_faces();
+    auto* screen_coordinates = context.arena().allocate<std::array<Vector2i, 3>>(number_faces);
+    parallel_for(job_system, 0, number_faces, 4096, [&](int first, int last)
     {
-        const auto& face = model.face(i);
-
-        std::array<Vector2i, 3> screen_coordinates;
-        for (int j = 0; j < 3; ++j)
+        for (int i = first; i < last; ++i)
         {
-            Vector3f world_coordinates{model.vertex(face[j])};
-            screen_coordinates[j] = Vector2i{static_cast<int>((world_coordinates.x + 1.0f) * width / 2.0f), 
-                                             static_cast<int>((world_coordinates.y + 1.0f) * height / 2.0f)};
+            const auto& face = model.face(i);
+            for (int j = 0; j < 3; ++j)
+            {
+                Vector3f world_coordinates{model.vertex(face[j])};
+                screen_coordinates[i][j] = Vector2i{static_cast<int>((world_coordinates.x + 1.0f) * width / 2.0f), 
+                                                    static_cast<int>((world_coordinates.y + 1.0f) * height / 2.0f)};
+            }
         }
+    });
+
+    /*
+    The triangles overlap without depth test, so each band of rows draws every triangle in face order
+    and the colors are keyed by face index: the image does not depend on the number of threads
+    */
+    const int band_height = 32;
+    parallel_for(job_system, 0, (height + band_height - 1) / band_height, 1, [&](int first_band, int last_band)
+    {
+        const int first_row = first_band * band_height;
+        const int last_row = last_band * band_height;
+        for (int i = 0; i < number_faces; ++i)
+        {
+            const auto& vertices = screen_coordinates[i];
+            if (std::max({vertices[0].y, vertices[1].y, vertices[2].y}) < first_row ||
+                std::min({vertices[0].y, vertices[1].y, vertices[2].y}) >= last_row)
+            {
+                continue;
+            }
+
+            const TGAColor color{random_uchar(i, 0), random_uchar(i, 1), random_uchar(i, 2), 255};
+            fill_colored_triangle(vertices[0], vertices[1], vertices[2], context.color(), color, first_row, last_row);
+        }
+    });
 
-        fill_colored_triangle(screen_coordinates[0], screen_coordinates[1], screen_coordinates[2], image, TGAColor{random_uchar(), random_uchar(), random_uchar(), 255});
-    }
-
-    image.flip_vertically(); // set origin to left bottom corner
-    const std::string output_file = "2." + model_name + "_colored_filled_triangle.tga";
-    image.write_tga_file(output_file.c_str());
-    image.clear();
+    const std::string output_file = "2." + model_name + "_colored_filled_triangle";
+    finish_frame(context, output_file);
 }
 
-void Scenes::draw_back_face_culling()
+void Scenes::draw_back_face_culling(RenderContext& context)
 {
+    begin_frame(context);
     const Vector3f light_direction{0, 0, -1};
 
     for (int i = 0; i < model.number_faces(); ++i)
@@ -103,20 +255,19 @@ void Scenes::draw_back_face_culling()
         {
             auto color = static_cast<unsigned char>(intensity * 255);
             fill_colored_triangle(screen_coordinates[0], screen_coordinates[1], screen_coordinates[2],
-                                  image, TGAColor{color, color, color, 255});
+                                  context.color(), TGAColor{color, color, color, 255});
         }
     }
 
-    image.flip_vertically(); // set origin to left bottom corner
-    const std::string output_file = "3." + model_name + "_back_face_culling.tga";
-    image.write_tga_file(output_file.c_str()); 
-    image.clear();
+    const std::string output_file = "3." + model_name + "_back_face_culling";
+    finish_frame(context, output_file);
 }
 
-void Scenes::draw_depth_buffer()
+void Scenes::draw_depth_buffer(RenderContext& context)
 {
+    begin_frame(context);
     const Vector3f light_direction{0, 0, -1};
-    std::vector<float> depth_buffer(width * height, std::numeric_limits<float>::lowest());
+    auto& depth_buffer = clear_depth_buffer(context);
 
     for (int i = 0; i < model.number_faces(); ++i)
     {
@@ -138,20 +289,19 @@ void Scenes::draw_depth_buffer()
         {
             auto color = static_cast<unsigned char>(intensity * 255);
             fill_colored_triangle(screen_coordinates[0], screen_coordinates[1], screen_coordinates[2],
-                                  depth_buffer, image, TGAColor{color, color, color, 255});
+                                  depth_buffer, context.color(), TGAColor{color, color, color, 255});
         }
     }
 
-    image.flip_vertically(); // set origin to left bottom corner
-    const std::string output_file = "4." + model_name + "_depth_buffer.tga";
-    image.write_tga_file(output_file.c_str()); 
-    image.clear();
+    const std::string output_file = "4." + model_name + "_depth_buffer";
+    finish_frame(context, output_file);
 }
 
-void Scenes::draw_textured_depth_buffer()
+void Scenes::draw_textured_depth_buffer(RenderContext& context)
 {
+    begin_frame(context);
     const Vector3f light_direction{0, 0, -1};
-    std::vector<float> depth_buffer(width * height, std::numeric_limits<float>::lowest());
+    auto& depth_buffer = clear_depth_buffer(context);
 
     for (int i = 0; i < model.number_faces(); ++i)
     {
@@ -173,25 +323,25 @@ void Scenes::draw_textured_depth_buffer()
         
         if (intensity > 0)
         {
-            fill_textured_triangle(screen_coordinates, uv_coordinates, model, depth_buffer, image);
+            fill_textured_triangle(screen_coordinates, uv_coordinates, model, depth_buffer, context.color());
         }
     }
 
-    image.flip_vertically(); // set origin to left bottom corner
-    const std::string output_file = "5." + model_name + "_texture_depth_buffer.tga";
-    image.write_tga_file(output_file.c_str()); 
-    image.clear();
+    const std::string output_file = "5." + model_name + "_texture_depth_buffer";
+    finish_frame(context, output_file);
 }
 
-void Scenes::draw_perspective_projection()
+void Scenes::draw_perspective_projection(RenderContext& context)
 {
+    begin_frame(context);
     const Vector3f light_direction{0, 0, -1};
     const Vector3f camera{0, 0, 3};
-    std::vector<float> depth_buffer(width * height, std::numeric_limits<float>::lowest());
+    auto& depth_buffer = clear_depth_buffer(context);
     
     Matrix projection_matrix = projection(camera.z);
     const auto viewport_matrix = viewport(width / 8, height / 8, width * 3 / 4, height * 3 / 4, depth);
     const auto projection_transform = viewport_matrix * projection_matrix;
+    const auto screen_vertices = transform_vertices(model, projection_transform, context.arena(), job_system);
     
     for (int i = 0; i < model.number_faces(); ++i)
     {
@@ -203,7 +353,7 @@ void Scenes::draw_perspective_projection()
         for (int j = 0; j < 3; ++j)
         {
             world_coordinates[j] = model.vertex(face[j]);
-            screen_coordinates[j] = cast<int>(homogeneous_to_cartesian(projection_transform * cartesian_to_homogeneous(world_coordinates[j]))); 
+            screen_coordinates[j] = screen_vertices[face[j]];
             uv_coordinates[j] = model.uv(i, j);
         }
 
@@ -213,27 +363,27 @@ void Scenes::draw_perspective_projection()
         
         if (intensity > 0)
         {
-            fill_textured_triangle(screen_coordinates, uv_coordinates, model, depth_buffer, image);
+            fill_textured_triangle(screen_coordinates, uv_coordinates, model, depth_buffer, context.color());
         }
     }
 
-    image.flip_vertically(); // set origin to left bottom corner
-    const std::string output_file = "6." + model_name + "_projective_perspective.tga";
-    image.write_tga_file(output_file.c_str()); 
-    image.clear();
+    const std::string output_file = "6." + model_name + "_projective_perspective";
+    finish_frame(context, output_file);
 }
 
-void Scenes::draw_gouraud_shading()
+void Scenes::draw_gouraud_shading(RenderContext& context)
 {
+    begin_frame(context);
     const Vector3f light_direction = unit_vector(Vector3f{1, -1, 1});
     const Vector3f camera{1, 1, 3};
     const Vector3f center{0, 0, 0};
-    std::vector<float> depth_buffer(width * height, std::numeric_limits<float>::lowest());
+    auto& depth_buffer = clear_depth_buffer(context);
     
     const auto view_matrix = look_at(camera, center, Vector3f{0, 1, 0});
     const auto projection_matrix = projection(float((camera - center).length()));
     const auto viewport_matrix = viewport(width / 8, height / 8, width * 3 / 4, height * 3 / 4, depth);
     const auto scene_transform = viewport_matrix * projection_matrix * view_matrix;
+    const auto screen_vertices = transform_vertices(model, scene_transform, context.arena(), job_system);
 
     for (int i = 0; i < model.number_faces(); ++i)
     {
@@ -245,30 +395,30 @@ void Scenes::draw_gouraud_shading()
         for (int j = 0; j < 3; ++j)
         {
             world_coordinates[j] = model.vertex(face[j]);
-            screen_coordinates[j] = cast<int>(homogeneous_to_cartesian(scene_transform * cartesian_to_homogeneous(world_coordinates[j])));
+            screen_coordinates[j] = screen_vertices[face[j]];
             intensities[j] = std::max(0.0f, float(dot(model.normal(i, j), light_direction)));
         }
 
-        fill_triangle_gouraud(screen_coordinates, intensities, depth_buffer, image);
+        fill_triangle_gouraud(screen_coordinates, intensities, depth_buffer, context.color());
     }
 
-    image.flip_vertically(); // set origin to left bottom corner
-    const std::string output_file = "7." + model_name + "_perspective_gouraud_shading.tga";
-    image.write_tga_file(output_file.c_str()); 
-    image.clear();
+    const std::string output_file = "7." + model_name + "_perspective_gouraud_shading";
+    finish_frame(context, output_file);
 }
 
-void Scenes::draw_look_at()
+void Scenes::draw_look_at(RenderContext& context)
 {
+    begin_frame(context);
     const Vector3f light_direction{0, 0, -1};
     const Vector3f camera{1, 1, 3};
     const Vector3f center{0, 0, 0};
-    std::vector<float> depth_buffer(width * height, std::numeric_limits<float>::lowest());
+    auto& depth_buffer = clear_depth_buffer(context);
     
     const auto view_matrix = look_at(camera, center, Vector3f{0, 1, 0});
     const auto projection_matrix = projection(float((camera - center).length()));
     const auto viewport_matrix = viewport(width / 8, height / 8, width * 3 / 4, height * 3 / 4, depth);
     const auto scene_transform = viewport_matrix * projection_matrix * view_matrix;
+    const auto screen_vertices = transform_vertices(model, scene_transform, context.arena(), job_system);
     
     for (int i = 0; i < model.number_faces(); ++i)
     {
@@ -280,7 +430,7 @@ void Scenes::draw_look_at()
         for (int j = 0; j < 3; ++j)
         {
             world_coordinates[j] = model.vertex(face[j]);
-            screen_coordinates[j] = cast<int>(homogeneous_to_cartesian(scene_transform * cartesian_to_homogeneous(world_coordinates[j]))); 
+            screen_coordinates[j] = screen_vertices[face[j]];
             uv_coordinates[j] = model.uv(i, j);
         }
 
@@ -290,66 +440,162 @@ void Scenes::draw_look_at()
         
         if (intensity > 0)
         {
-            fill_textured_triangle(screen_coordinates, uv_coordinates, intensity, model, depth_buffer, image);
+            fill_textured_triangle(screen_coordinates, uv_coordinates, intensity, model, depth_buffer, context.color());
         }
     }
 
-    image.flip_vertically(); // set origin to left bottom corner
-    const std::string output_file = "8." + model_name + "_look_at.tga";
-    image.write_tga_file(output_file.c_str()); 
-    image.clear();
+    const std::string output_file = "8." + model_name + "_look_at";
+    finish_frame(context, output_file);
 }
 
-void Scenes::draw_our_gl(ShadersOptions shader_choice)
+void Scenes::draw_our_gl(RenderContext& context, ShadersOptions shader_choice)
 {
-    const auto light_direction = unit_vector(Vector3f{1, 1, 1});
-    const Vector3f camera{1, 1, 3};
-    const Vector3f center{0, 0, 0};
-    std::vector<float> depth_buffer(width * height, std::numeric_limits<float>::lowest());
-    
-    const auto view_matrix = look_at(camera, center, Vector3f{0, 1, 0});
-    const auto projection_matrix = projection(float((camera - center).length()));
-    const auto viewport_matrix = viewport(width / 8, height / 8, width * 3 / 4, height * 3 / 4, depth);
-    const auto model_view_projection_transform = projection_matrix * view_matrix;
-    const auto scene_transform = viewport_matrix * model_view_projection_transform;
-    
-    std::unique_ptr<Shader> shader;
-    std::string output_file{"9." + model_name + "_our_gl"};
-    if (shader_choice == ShadersOptions::Gouraud)
+    PROFILE_SCOPE("draw_our_gl_" + shader_name(shader_choice));
+    begin_frame(context);
+    RenderSettings settings;
+    settings.shader = shader_choice;
+    settings.depth = depth;
+    context.clear(false);
+    const std::string output_file{"9." + model_name + "_our_gl_" + shader_name(shader_choice)};
+    render_our_gl(settings, context, output_file);
+
+    finish_frame(context, output_file);
+}
+
+void Scenes::draw_our_gl_orbit(RenderScheduler& scheduler, ShadersOptions shader_choice, int number_views)
+{
+    // The default camera {1, 1, 3} rotated around the vertical axis through the center
+    const float radius = std::sqrt(10.0f);
+    const float initial_angle = std::atan2(1.0f, 3.0f);
+    const float pi = std::acos(-1.0f);
+
+    for (int view = 0; view < number_views; ++view)
     {
-        shader = std::make_unique<Gouraud>(model, model_view_projection_transform, viewport_matrix, light_direction);
-        output_file += "_gouraud.tga";
+        scheduler.submit([this, shader_choice, view, number_views, radius, initial_angle, pi](RenderContext& context)
+        {
+            PROFILE_SCOPE("draw_our_gl_orbit_" + std::to_string(view));
+            const float angle = initial_angle + 2.0f * pi * view / number_views;
+            RenderSettings settings;
+            settings.camera.eye = Vector3f{radius * std::sin(angle), 1.0f, radius * std::cos(angle)};
+            settings.shader = shader_choice;
+            settings.depth = depth;
+
+            begin_frame(context);
+            context.clear(false);
+            const std::string output_file{"10." + model_name + "_orbit_" + shader_name(shader_choice) + "_" + std::to_string(view)};
+            render_our_gl(settings, context, output_file);
+            finish_frame(context, output_file);
+        });
     }
-    else if (shader_choice == ShadersOptions::BasicTexture)
+}
+
+void Scenes::draw_our_gl_tiled(ShadersOptions shader_choice, int output_width, int output_height, int tile_size)
+{
+    PROFILE_SCOPE("draw_our_gl_tiled_" + shader_name(shader_choice));
+    PROFILE_COUNT(TrianglesIn, model.number_faces());
+    RenderSettings settings;
+    settings.shader = shader_choice;
+    settings.depth = depth;
+
+    /*
+    Bin the triangles into the tiles overlapped by their bounding boxes. Each job transforms a range of
+    triangles with a shader of its own and bins them into a grid of its own; the grids are appended in
+    order, so every tile lists its triangles in the original order and the result does not depend on
+    the number of threads. The bins are allocated from the frame arena of the thread filling them
+    */
+    const int number_threads = job_system != nullptr ? job_system->number_threads() + 1 : 1;
+    if (static_cast<int>(tiled_arenas.size()) != number_threads)
     {
-        shader = std::make_unique<BasicTexture>(model, model_view_projection_transform, viewport_matrix, light_direction);
-        output_file += "_basic_texture.tga";
+        tiled_arenas.resize(number_threads);
     }
-    else if (shader_choice == ShadersOptions::NormalMappingTexture)
+    for (auto& arena: tiled_arenas)
     {
-        shader = std::make_unique<Texture>(model, model_view_projection_transform, viewport_matrix, light_direction);
-        output_file += "_normal_mapping.tga";
+        arena.reset();
     }
-    else if (shader_choice == ShadersOptions::Phong)
+    auto thread_arena = [this]() -> FrameArena&
     {
-        shader = std::make_unique<Phong>(model, model_view_projection_transform, viewport_matrix, light_direction);
-        output_file += "_phong.tga";
+        return tiled_arenas[job_system != nullptr ? job_system->current_thread_index() + 1 : 0];
+    };
+
+    const int number_faces = model.number_faces();
+    const int binning_grain_size = 4096;
+    const int number_ranges = (number_faces + binning_grain_size - 1) / binning_grain_size;
+    auto& calling_arena = thread_arena();
+    TileGrid* range_tiles = calling_arena.allocate<TileGrid>(number_ranges);
+    for (int range = 0; range < number_ranges; ++range)
+    {
+        new (range_tiles + range) TileGrid{output_width, output_height, tile_size, calling_arena};
     }
-
-    for (int i = 0; i < model.number_faces(); ++i)
+    parallel_for(job_system, 0, number_faces, binning_grain_size, [&](int first, int last)
     {
-        std::array<Vector3f, 3> screen_coordinates;
-        for (int j = 0; j < 3; ++j)
+        auto shader = make_shader(model, settings, output_width, output_height);
+        auto& tiles = range_tiles[first / binning_grain_size];
+        auto& arena = thread_arena();
+        for (int i = first; i < last; ++i)
         {
-            screen_coordinates[j] = shader->vertex(i, j);
+            std::array<Vector3f, 3> screen_coordinates;
+            for (int j = 0; j < 3; ++j)
+            {
+                screen_coordinates[j] = shader->vertex(i, j);
+            }
+
+            tiles.insert(i, screen_coordinates, arena);
         }
-        
-        rasterize(screen_coordinates, *shader, image, depth_buffer);
+    });
+
+    TileGrid tiles{output_width, output_height, tile_size, calling_arena};
+    for (int range = 0; range < number_ranges; ++range)
+    {
+        tiles.append(range_tiles[range]);
     }
 
-    image.flip_vertically(); // set origin to left bottom corner
-    image.write_tga_file(output_file.c_str()); 
-    image.clear();
+    const std::string output_file{output_directory + "9." + model_name + "_our_gl_" + shader_name(shader_choice) + "_" 
+                                  + std::to_string(output_width) + "x" + std::to_string(output_height) + ".tga"};
+    TGAStreamWriter writer{output_file.c_str(), output_width, output_height, TGAImage::RGB, true, TGAStreamWriter::BOTTOM_UP};
+    std::mutex writer_mutex;
+    
+    // Tiles are rasterized as independent jobs; each job only keeps the color and depth buffers of its current tile
+    const int number_tiles = tiles.number_tiles_x() * tiles.number_tiles_y();
+    parallel_for(job_system, 0, number_tiles, 1, [&](int first, int last)
+    {
+        auto shader = make_shader(model, settings, output_width, output_height);
+        TGAImage tile_image{tile_size, tile_size, TGAImage::RGB};
+        DepthBuffer tile_depth_buffer(tile_size * tile_size);
+
+        for (int tile = first; tile < last; ++tile)
+        {
+            const int tile_x = tile % tiles.number_tiles_x();
+            const int tile_y = tile / tiles.number_tiles_x();
+            const auto origin = tiles.tile_origin(tile_x, tile_y);
+            const auto dimensions = tiles.tile_dimensions(tile_x, tile_y);
+            if (tile_image.get_width() != dimensions.x || tile_image.get_height() != dimensions.y)
+            {
+                tile_image = TGAImage{dimensions.x, dimensions.y, TGAImage::RGB};
+            }
+            else
+            {
+                tile_image.clear();
+            }
+            std::fill(tile_depth_buffer.begin(), tile_depth_buffer.end(), std::numeric_limits<float>::lowest());
+
+            // Re-submit the triangles overlapping this tile
+            for (const auto i: tiles.triangles(tile_x, tile_y))
+            {
+                std::array<Vector3f, 3> screen_coordinates;
+                for (int j = 0; j < 3; ++j)
+                {
+                    screen_coordinates[j] = shader->vertex(i, j);
+                }
+
+                rasterize(screen_coordinates, *shader, tile_image, tile_depth_buffer, origin);
+            }
+
+            std::lock_guard<std::mutex> lock{writer_mutex};
+            writer.write_tile(origin.x, origin.y, tile_image);
+        }
+    });
+
+    writer.close();
 }
 
 std::string parse_filename(const std::string& filename, char target)
@@ -359,8 +605,53 @@ std::string parse_filename(const std::string& filename, char target)
     
     if (target_position == std::string::npos) 
     {
-        return filename.substr(0, filename.size() - extension_size - 1);
+        return filename.substr(0, filename.size() - extension_size);
     }
 
     return filename.substr(target_position + 1, filename.size() - target_position - extension_size - 1);
+}
+
+void draw_streamed_gouraud_shading(const std::string& stream_filename, ImageFormat output_format, int image_width, int image_height)
+{
+    TriangleStream stream{stream_filename};
+    if (!stream.is_open())
+    {
+        return;
+    }
+
+    const int depth{255};
+    const Vector3f light_direction = unit_vector(Vector3f{1, -1, 1});
+    const Vector3f camera{1, 1, 3};
+    const Vector3f center{0, 0, 0};
+    TGAImage image{image_width, image_height, TGAImage::RGB};
+    DepthBuffer depth_buffer(image_width * image_height, std::numeric_limits<float>::lowest());
+
+    const auto view_matrix = look_at(camera, center, Vector3f{0, 1, 0});
+    const auto projection_matrix = projection(float((camera - center).length()));
+    const auto viewport_matrix = viewport(image_width / 8, image_height / 8, image_width * 3 / 4, image_height * 3 / 4, depth);
+    const auto scene_transform = viewport_matrix * projection_matrix * view_matrix;
+
+    while (const auto* batch = stream.acquire_batch())
+    {
+        for (const auto& triangle: *batch)
+        {
+            std::array<Vector3i, 3> screen_coordinates;
+            std::array<float, 3> intensities;
+
+            for (int j = 0; j < 3; ++j)
+            {
+                const Vector3f position{triangle.position[j][0], triangle.position[j][1], triangle.position[j][2]};
+                const Vector3f normal{triangle.normal[j][0], triangle.normal[j][1], triangle.normal[j][2]};
+                screen_coordinates[j] = cast<int>(homogeneous_to_cartesian(scene_transform * cartesian_to_homogeneous(position)));
+                intensities[j] = std::max(0.0f, float(dot(normal, light_direction)));
+            }
+
+            fill_triangle_gouraud(screen_coordinates, intensities, depth_buffer, image);
+        }
+
+        stream.release_batch();
+    }
+
+    const std::string output_file = "7." + parse_filename(stream_filename) + "_streamed_gouraud_shading";
+    write_image(image, output_file, output_format);
 }
\ No newline at end of file
@@ -1,63 +1,134 @@
 #ifndef SCENES_HPP
 #define SCENES_HPP
 
+#include "framearena.hpp"
+#include "framewriter.hpp"
+#include "matrix.hpp"
+#include "renderer.hpp"
+#include "jobsystem.hpp"
+#include "renderscheduler.hpp"
 #include "tgaimage.h"
 #include "trianglemesh.hpp"
 #include "vector.hpp"
 #include <string>
-
-// List of available shaders
-enum class ShadersOptions
-{
-    Gouraud,
-    BasicTexture,
-    NormalMappingTexture,
-    Phong
-};
+#include <thread>
+#include <vector>
 
 Vector3i world_to_screen(Vector3f pos, int width, int heigth);
 
+// Transform each vertex of the model to screen coordinates once, instead of once per face; the result is allocated from arena
+const Vector3i* transform_vertices(const TriangleMesh& model, const Matrix& transform, FrameArena& arena, JobSystem* job_system = nullptr);
+
 class Scenes
 {
 public:
-    Scenes(const std::string& filename, int image_width = 600, int image_height = 600);
+    // Vertex processing, binning, tile rasterization and output encoding run as jobs of job_system if given
+    Scenes(const std::string& filename, const MeshLoadOptions& mesh_options = MeshLoadOptions{}, 
+           int image_width = 600, int image_height = 600, JobSystem* job_system = nullptr);
+
+    // Render an in-memory mesh, e.g. from generate_mesh; model_name prefixes the output files
+    Scenes(TriangleMesh mesh, const std::string& model_name, int image_width = 600, int image_height = 600,
+           JobSystem* job_system = nullptr);
     
+    // Block until every rendered image is written; returns false if any write failed
+    bool wait_for_output();
+
+    // Format of the images written by the draw_* methods, except draw_our_gl_tiled which always writes TGA
+    void set_output_format(ImageFormat format);
+
+    // Existing directory the images are written to, the working directory by default
+    void set_output_directory(const std::string& directory);
+
+    // Render the Our GL scenes (except draw_our_gl_tiled) with the streaming pipeline of render_pipelined
+    void set_pipelined(bool enabled);
+
+    /*
+    Also write debug heatmaps of the Our GL scenes (except draw_our_gl_tiled) next to each image: the depth
+    tests, the fragment shader invocations, the fragment shader cycles and, for the textured shaders, the
+    texel footprint per pixel (see DebugTargets)
+    */
+    void set_heatmaps(bool enabled);
+
+    /*
+    Every scene except draw_our_gl_tiled draws into the given render context, which must have the size of the
+    scenes. The model is only read, so scenes using different contexts can be drawn concurrently
+    */
+
     // Chapter 1 final render: wire frame mesh
-    void draw_wire_mesh();
+    void draw_wire_mesh(RenderContext& context);
 
     // Chapter 2 render: triangles filled with random colors
-    void draw_random_colored_triangles();
+    void draw_random_colored_triangles(RenderContext& context);
 
     // Chapter 2 final render: triangles filled with colors proportional to lighting intensity
-    void draw_back_face_culling();
+    void draw_back_face_culling(RenderContext& context);
 
     // Chapter 3 final render: model with back face culling and depth buffering 
-    void draw_depth_buffer();
+    void draw_depth_buffer(RenderContext& context);
 
     // Chapter 3 homework: add textures to draw_depth_buffer
-    void draw_textured_depth_buffer();
+    void draw_textured_depth_buffer(RenderContext& context);
 
     // Chapter 4: perspective projection
-    void draw_perspective_projection();
+    void draw_perspective_projection(RenderContext& context);
 
     // Chapter 5: Gouraud shading
-    void draw_gouraud_shading();
+    void draw_gouraud_shading(RenderContext& context);
 
     // Chapter 5: perspective projection with camera transformation
-    void draw_look_at();
+    void draw_look_at(RenderContext& context);
 
     // Chapter 6: Our GL with shaders
-    void draw_our_gl(ShadersOptions shader_choice = ShadersOptions::NormalMappingTexture);
+    void draw_our_gl(RenderContext& context, ShadersOptions shader_choice = ShadersOptions::NormalMappingTexture);
+
+    // Our GL rendered from number_views cameras orbiting the model, one job per view
+    void draw_our_gl_orbit(RenderScheduler& scheduler, ShadersOptions shader_choice, int number_views);
+
+    /*
+    Chapter 6: Our GL rendered at an arbitrary resolution one screen tile at a time. Only the
+    color and depth buffers of one tile per thread are kept in memory and finished tiles are
+    written directly to the output file
+    */
+    void draw_our_gl_tiled(ShadersOptions shader_choice, int output_width, int output_height, int tile_size = 256);
 
 private:
+    // Give the context a cleared frame from the frame writer as color target, and reset its frame arena
+    void begin_frame(RenderContext& context);
+
+    // Eagerly reset the depth buffer for the chapter scenes, which rasterize outside of the context
+    DepthBuffer& clear_depth_buffer(RenderContext& context);
+
+    // Hand the rendered image to the frame writer
+    void finish_frame(RenderContext& context, const std::string& output_file);
+
+    // Render Our GL into the context, and the heatmaps named after output_file if enabled
+    void render_our_gl(const RenderSettings& settings, RenderContext& context, const std::string& output_file);
+
+    // Color the values of a debug target into a frame and hand it to the frame writer
+    template<typename T>
+    void write_heatmap_frame(const std::vector<T>& values, const std::string& output_file, const char* unit);
+
+    JobSystem* job_system;
+    FrameWriter frame_writer; // one frame per thread rendering, plus one being written
     TriangleMesh model;
     std::string model_name;
     const int width;
     const int height;
     const int depth{255};
-    TGAImage image;
+    ImageFormat output_format{ImageFormat::TGA};
+    std::string output_directory; // empty or ending with a separator
+    bool pipelined{false};
+    bool heatmaps{false};
+    std::vector<FrameArena> tiled_arenas; // binning storage of draw_our_gl_tiled, per worker of job_system plus one
 };
 
 std::string parse_filename(const std::string& filename, char target = '/');
 
+/*
+Out-of-core version of Scenes::draw_gouraud_shading: renders a triangle stream (see write_triangle_stream)
+batch by batch as it is read from disk, so the mesh never has to fit in memory
+*/
+void draw_streamed_gouraud_shading(const std::string& stream_filename, ImageFormat output_format = ImageFormat::TGA,
+                                   int image_width = 600, int image_height = 600);
+
 #endif // SCENES_HPP
\ No newline at end of file
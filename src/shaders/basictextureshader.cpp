@@ -24,3 +24,30 @@ bool BasicTexture::fragment(Vector3f barycentric_coordinates, TGAColor& color)
     color = model.diffuse_map_at(uv) * intensity;
     return false;    
 }
+
+float BasicTexture::texture_footprint(const FragmentQuad& quad) const
+{
+    return texel_footprint(quad, varying_uv, model.diffuse_map_size());
+}
+
+void BasicTexture::save_varyings(Varyings& varyings) const
+{
+    float* value = varyings.values.data();
+    for (int i = 0; i < 3; ++i)
+    {
+        *value++ = varying_intensity[i];
+        *value++ = varying_uv[i].x;
+        *value++ = varying_uv[i].y;
+    }
+}
+
+void BasicTexture::load_varyings(const Varyings& varyings)
+{
+    const float* value = varyings.values.data();
+    for (int i = 0; i < 3; ++i)
+    {
+        varying_intensity[i] = *value++;
+        varying_uv[i].x = *value++;
+        varying_uv[i].y = *value++;
+    }
+}
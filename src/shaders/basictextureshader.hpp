@@ -27,6 +27,9 @@ struct BasicTexture: Shader
 
     Vector3f vertex(int face, int vertex_number) override;
     bool fragment(Vector3f barycentric_coordinates, TGAColor& color) override;
+    float texture_footprint(const FragmentQuad& quad) const override;
+    void save_varyings(Varyings& varyings) const override;
+    void load_varyings(const Varyings& varyings) override;
 };
 
 #endif // BASIC_TEXTURE_HPP
\ No newline at end of file
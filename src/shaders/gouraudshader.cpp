@@ -24,3 +24,19 @@ bool Gouraud::fragment(Vector3f barycentric_coordinates, TGAColor& color)
     return false;
 }
 
+
+void Gouraud::save_varyings(Varyings& varyings) const
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        varyings.values[i] = varying_intensity[i];
+    }
+}
+
+void Gouraud::load_varyings(const Varyings& varyings)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        varying_intensity[i] = varyings.values[i];
+    }
+}
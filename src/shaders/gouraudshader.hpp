@@ -22,6 +22,8 @@ struct Gouraud: public Shader
             const Matrix& viewport_transform, const Vector3f& light_dir);
     Vector3f vertex(int face, int vertex_number) override;
     bool fragment(Vector3f barycentric_coordinates, TGAColor& color) override;
+    void save_varyings(Varyings& varyings) const override;
+    void load_varyings(const Varyings& varyings) override;
 };
 
 #endif // GOURAUD_SHADER_HPP
\ No newline at end of file
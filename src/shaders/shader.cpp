@@ -1,4 +1,43 @@
 #include "shader.hpp"
+#include "tgaimage.h"
+#include <algorithm>
+#include <cmath>
+
+std::array<float, 4> FragmentQuad::interpolate(const Vector3f& vertex_values) const
+{
+    std::array<float, 4> values;
+    for (int lane = 0; lane < 4; ++lane)
+    {
+        values[lane] = float(dot(barycentric_coordinates[lane], vertex_values));
+    }
+
+    return values;
+}
+
+float texel_footprint(const FragmentQuad& quad, const std::array<Vector2f, 3>& uv, Vector2i texture_size)
+{
+    const auto u = quad.interpolate(Vector3f{uv[0].x, uv[1].x, uv[2].x});
+    const auto v = quad.interpolate(Vector3f{uv[0].y, uv[1].y, uv[2].y});
+    const Vector2f along_x{ddx(u) * texture_size.x, ddx(v) * texture_size.y};
+    const Vector2f along_y{ddy(u) * texture_size.x, ddy(v) * texture_size.y};
+    return std::sqrt(std::max(along_x.x * along_x.x + along_x.y * along_x.y, along_y.x * along_y.x + along_y.y * along_y.y));
+}
 
 Shader::~Shader()
-{}
\ No newline at end of file
+{}
+
+void Shader::fragment_quad(const FragmentQuad& quad, std::array<TGAColor, 4>& colors, std::array<bool, 4>& discarded)
+{
+    for (int lane = 0; lane < 4; ++lane)
+    {
+        if (quad.live[lane])
+        {
+            discarded[lane] = fragment(quad.barycentric_coordinates[lane], colors[lane]);
+        }
+    }
+}
+
+float Shader::texture_footprint(const FragmentQuad&) const
+{
+    return 0.0f;
+}
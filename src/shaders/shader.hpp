@@ -2,14 +2,74 @@
 #define SHADER_HPP
 
 #include "vector.hpp"
+#include <array>
 
 struct TGAColor;
 
+/*
+Per-triangle varyings of a shader flattened into floats. A triangle can then be vertex shaded by
+one shader and its fragments shaded by another one, e.g. on a different thread
+*/
+struct Varyings
+{
+    static constexpr int max_size = 32;
+    std::array<float, max_size> values;
+};
+
+/*
+2x2 pixels shaded together: lane i is the pixel origin + (i % 2, i / 2). Every lane has the barycentric
+coordinates of its pixel, extrapolated for the lanes outside of the triangle, so that the varyings can be
+differentiated across the quad. Only the live lanes, covered and passing the depth test, are written: the
+others are helper lanes.
+*/
+struct FragmentQuad
+{
+    Vector2i origin;
+    std::array<Vector3f, 4> barycentric_coordinates;
+    std::array<bool, 4> live;
+
+    // Varying at the four lanes, from its values at the three vertices
+    std::array<float, 4> interpolate(const Vector3f& vertex_values) const;
+};
+
+// Coarse finite differences of a varying along x and y, the same for the four lanes of the quad
+template<typename T>
+T ddx(const std::array<T, 4>& values)
+{
+    return values[1] - values[0];
+}
+
+template<typename T>
+T ddy(const std::array<T, 4>& values)
+{
+    return values[2] - values[0];
+}
+
+/*
+Texels of a texture of texture_size covered by a pixel of the quad along its longer screen axis, from the
+derivatives of the uv varyings: a mip chain would sample the level log2 of it
+*/
+float texel_footprint(const FragmentQuad& quad, const std::array<Vector2f, 3>& uv, Vector2i texture_size);
+
 struct Shader
 {
     virtual ~Shader();
     virtual Vector3f vertex(int face, int vertex_number) = 0;
     virtual bool fragment(Vector3f barycentric_coordinates, TGAColor& color) = 0;
+
+    /*
+    Shade the live lanes of a quad, setting discarded like the return value of fragment; colors and
+    discarded are ignored for the helper lanes. The default calls fragment for each live lane, a shader
+    may override it to use derivatives
+    */
+    virtual void fragment_quad(const FragmentQuad& quad, std::array<TGAColor, 4>& colors, std::array<bool, 4>& discarded);
+
+    // Texel footprint of the diffuse texture sampled by the shader at the quad, 0 if it samples none (for the debug heatmaps)
+    virtual float texture_footprint(const FragmentQuad& quad) const;
+
+    // Copy the varyings read by fragment, as written by the last three calls of vertex
+    virtual void save_varyings(Varyings& varyings) const = 0;
+    virtual void load_varyings(const Varyings& varyings) = 0;
 };
 
-#endif // SHADER_HPP
\ No newline at end of file
+#endif // SHADER_HPP
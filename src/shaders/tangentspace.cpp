@@ -0,0 +1,26 @@
+#include "tangentspace.hpp"
+
+TangentSpace tangent_space(const std::array<Vector3f, 3>& ndc, const std::array<Vector2f, 3>& uv)
+{
+    return TangentSpace{ndc[1] - ndc[0], ndc[2] - ndc[0],
+                        Vector3f{uv[1].x - uv[0].x, uv[2].x - uv[0].x, 0.0f},
+                        Vector3f{uv[1].y - uv[0].y, uv[2].y - uv[0].y, 0.0f}};
+}
+
+Matrix tangent_basis(const TangentSpace& triangle, const Vector3f& normal)
+{
+    Matrix A{3, 3};
+    A.fill_row(0, triangle.ndc_edge1);
+    A.fill_row(1, triangle.ndc_edge2);
+    A.fill_row(2, normal);
+
+    auto inverse_A = inverse_3x3(A);
+    Vector3f i = inverse_A * triangle.delta_u;
+    Vector3f j = inverse_A * triangle.delta_v;
+
+    Matrix B{3, 3};
+    B.fill_column(0, unit_vector(i));
+    B.fill_column(1, unit_vector(j));
+    B.fill_column(2, normal);
+    return B;
+}
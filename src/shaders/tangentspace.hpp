@@ -0,0 +1,26 @@
+#ifndef TANGENT_SPACE_HPP
+#define TANGENT_SPACE_HPP
+
+#include "matrix.hpp"
+#include "vector.hpp"
+#include <array>
+
+/*
+Terms of the tangent space basis of the normal mapping shaders that only depend on the triangle: the
+NDC edges and uv differences from vertex 0. They are computed once per triangle, only the interpolated
+normal changes per pixel.
+*/
+struct TangentSpace
+{
+    Vector3f ndc_edge1;
+    Vector3f ndc_edge2;
+    Vector3f delta_u;
+    Vector3f delta_v;
+};
+
+TangentSpace tangent_space(const std::array<Vector3f, 3>& ndc, const std::array<Vector2f, 3>& uv);
+
+// Basis of the tangent space at a pixel (tangent, bitangent and normal columns), from its unit interpolated normal
+Matrix tangent_basis(const TangentSpace& triangle, const Vector3f& normal);
+
+#endif // TANGENT_SPACE_HPP
@@ -16,6 +16,11 @@ Vector3f Texture::vertex(int face, int vertex_number)
     const auto gl_vertex = uniform_mvp * cartesian_to_homogeneous(model.vertex(face, vertex_number));
     varying_triangle_coordinates[vertex_number] = gl_vertex;
     varying_ndc[vertex_number] = homogeneous_to_cartesian(gl_vertex);
+    if (vertex_number == 2)
+    {
+        varying_tangent_space = tangent_space(varying_ndc, varying_uv);
+    }
+
     return homogeneous_to_cartesian(uniform_viewport * gl_vertex);
 }
 
@@ -31,23 +36,49 @@ bool Texture::fragment(Vector3f barycentric_coordinates, TGAColor& color)
         float(dot(barycentric_coordinates, Vector3f{varying_normal[0].z, varying_normal[1].z, varying_normal[2].z}))
     });
 
-    Matrix A{3, 3};
-    A.fill_row(0, varying_ndc[1] - varying_ndc[0]);
-    A.fill_row(1, varying_ndc[2] - varying_ndc[0]);
-    A.fill_row(2, normal);
-
-    auto inverse_A = inverse_3x3(A);
-    Vector3f i = inverse_A * Vector3f{varying_uv[1].x - varying_uv[0].x, varying_uv[2].x - varying_uv[0].x, 0.0f};
-    Vector3f j = inverse_A * Vector3f{varying_uv[1].y - varying_uv[0].y, varying_uv[2].y - varying_uv[0].y, 0.0f};
-
-    Matrix B{3, 3};
-    B.fill_column(0, unit_vector(i));
-    B.fill_column(1, unit_vector(j));
-    B.fill_column(2, normal);
-
+    Matrix B = tangent_basis(varying_tangent_space, normal);
     Vector3f n = unit_vector(B * model.normal_map_at(uv));
     const float diff = std::max(0.0f, float(dot(n, light_direction)));
     color = model.diffuse_map_at(uv) * diff;
     
     return false;
-}
\ No newline at end of file
+}
+
+float Texture::texture_footprint(const FragmentQuad& quad) const
+{
+    return texel_footprint(quad, varying_uv, model.diffuse_map_size());
+}
+
+void Texture::save_varyings(Varyings& varyings) const
+{
+    float* value = varyings.values.data();
+    for (int i = 0; i < 3; ++i)
+    {
+        *value++ = varying_uv[i].x;
+        *value++ = varying_uv[i].y;
+        *value++ = varying_normal[i].x;
+        *value++ = varying_normal[i].y;
+        *value++ = varying_normal[i].z;
+        *value++ = varying_ndc[i].x;
+        *value++ = varying_ndc[i].y;
+        *value++ = varying_ndc[i].z;
+    }
+}
+
+void Texture::load_varyings(const Varyings& varyings)
+{
+    const float* value = varyings.values.data();
+    for (int i = 0; i < 3; ++i)
+    {
+        varying_uv[i].x = *value++;
+        varying_uv[i].y = *value++;
+        varying_normal[i].x = *value++;
+        varying_normal[i].y = *value++;
+        varying_normal[i].z = *value++;
+        varying_ndc[i].x = *value++;
+        varying_ndc[i].y = *value++;
+        varying_ndc[i].z = *value++;
+    }
+
+    varying_tangent_space = tangent_space(varying_ndc, varying_uv);
+}
@@ -3,6 +3,7 @@
 
 #include "matrix.hpp"
 #include "shader.hpp"
+#include "tangentspace.hpp"
 #include <array>
 
 class TriangleMesh;
@@ -22,12 +23,16 @@ struct Texture: Shader
     std::array<Vector3f, 3> varying_normal;
     std::array<Matrix, 3> varying_triangle_coordinates;
     std::array<Vector3f, 3> varying_ndc;
+    TangentSpace varying_tangent_space; // of the triangle, set with the third vertex or by load_varyings
 
     Texture(const TriangleMesh& object, const Matrix& model_view_transform, 
             const Matrix& viewport_transform, const Vector3f& light_dir);
 
     Vector3f vertex(int face, int vertex_number) override;
     bool fragment(Vector3f barycentric_coordinates, TGAColor& color) override;
+    float texture_footprint(const FragmentQuad& quad) const override;
+    void save_varyings(Varyings& varyings) const override;
+    void load_varyings(const Varyings& varyings) override;
 };
 
 #endif // TEXTURE_SHADER_HPP
\ No newline at end of file
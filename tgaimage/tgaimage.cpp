@@ -3,6 +3,9 @@
 #include <string.h>
 #include <time.h>
 #include <math.h>
+#include <algorithm>
+#include <functional>
+#include <thread>
 #include "tgaimage.h"
 
 TGAImage::TGAImage() : data(NULL), width(0), height(0), bytespp(0) {
@@ -20,6 +23,11 @@ TGAImage::TGAImage(const TGAImage &img) : data(NULL), width(img.width), height(i
     memcpy(data, img.data, nbytes);
 }
 
+TGAImage::TGAImage(TGAImage &&img) : data(img.data), width(img.width), height(img.height), bytespp(img.bytespp) {
+    img.data = NULL;
+    img.width = img.height = img.bytespp = 0;
+}
+
 TGAImage::~TGAImage() {
     if (data) delete [] data;
 }
@@ -37,112 +45,156 @@ TGAImage & TGAImage::operator =(const TGAImage &img) {
     return *this;
 }
 
-bool TGAImage::read_tga_file(const char *filename) {
+TGAImage & TGAImage::operator =(TGAImage &&img) {
+    if (this != &img) {
+        if (data) delete [] data;
+        data = img.data;
+        width  = img.width;
+        height = img.height;
+        bytespp = img.bytespp;
+        img.data = NULL;
+        img.width = img.height = img.bytespp = 0;
+    }
+    return *this;
+}
+
+bool TGAImage::read_tga_file(const char *filename, bool bottom_left_origin) {
     if (data) delete [] data;
     data = NULL;
     std::ifstream in;
-    in.open (filename, std::ios::binary);
+    in.open (filename, std::ios::binary | std::ios::ate);
     if (!in.is_open()) {
         std::cerr << "can't open file " << filename << "\n";
         in.close();
         return false;
     }
-    TGA_Header header;
-    in.read((char *)&header, sizeof(header));
-    if (!in.good()) {
+    // The whole file is read at once and decoded from memory
+    std::streamsize file_size = in.tellg();
+    in.seekg(0, std::ios::beg);
+    if (file_size<(std::streamsize)sizeof(TGA_Header)) {
         in.close();
         std::cerr << "an error occured while reading the header\n";
         return false;
     }
+    std::vector<unsigned char> file(file_size);
+    in.read((char *)file.data(), file_size);
+    in.close();
+    if (!in) {
+        std::cerr << "an error occured while reading the data\n";
+        return false;
+    }
+    TGA_Header header;
+    memcpy(&header, file.data(), sizeof(header));
     width   = header.width;
     height  = header.height;
     bytespp = header.bitsperpixel>>3;
     if (width<=0 || height<=0 || (bytespp!=GRAYSCALE && bytespp!=RGB && bytespp!=RGBA)) {
-        in.close();
         std::cerr << "bad bpp (or width/height) value\n";
         return false;
     }
+    unsigned long offset = sizeof(header) + (unsigned char)header.idlength;
+    if (offset>file.size()) {
+        std::cerr << "an error occured while reading the data\n";
+        return false;
+    }
+    const unsigned char *pixels = file.data()+offset;
+    unsigned long available = file.size()-offset;
+    // Rows are decoded directly into the requested orientation
+    bool reverse_rows = ((header.imagedescriptor & 0x20)!=0)==bottom_left_origin;
+    unsigned long bytes_per_line = width*bytespp;
     unsigned long nbytes = bytespp*width*height;
     data = new unsigned char[nbytes];
     if (3==header.datatypecode || 2==header.datatypecode) {
-        in.read((char *)data, nbytes);
-        if (!in.good()) {
-            in.close();
+        if (available<nbytes) {
             std::cerr << "an error occured while reading the data\n";
             return false;
         }
+        for (int j=0; j<height; j++) {
+            int row = reverse_rows ? height-1-j : j;
+            memcpy(data+row*bytes_per_line, pixels+j*bytes_per_line, bytes_per_line);
+        }
     } else if (10==header.datatypecode||11==header.datatypecode) {
-        if (!load_rle_data(in)) {
-            in.close();
+        if (!load_rle_data(pixels, available, reverse_rows)) {
             std::cerr << "an error occured while reading the data\n";
             return false;
         }
     } else {
-        in.close();
         std::cerr << "unknown file format " << (int)header.datatypecode << "\n";
         return false;
     }
-    if (!(header.imagedescriptor & 0x20)) {
-        flip_vertically();
-    }
     if (header.imagedescriptor & 0x10) {
         flip_horizontally();
     }
     std::cerr << width << "x" << height << "/" << bytespp*8 << "\n";
-    in.close();
     return true;
 }
 
-bool TGAImage::load_rle_data(std::ifstream &in) {
-    unsigned long pixelcount = width*height;
-    unsigned long currentpixel = 0;
-    unsigned long currentbyte  = 0;
-    TGAColor colorbuffer;
-    do {
-        unsigned char chunkheader = 0;
-        chunkheader = in.get();
-        if (!in.good()) {
+// Fill count pixels with the same color by doubling the filled region on each copy
+static void fill_pixels(unsigned char *dst, const unsigned char *color, unsigned long count, int bytespp) {
+    if (1==bytespp) {
+        memset(dst, color[0], count);
+        return;
+    }
+    unsigned long total = count*bytespp;
+    unsigned long filled = bytespp;
+    memcpy(dst, color, bytespp);
+    while (filled<total) {
+        unsigned long chunk = (filled<total-filled ? filled : total-filled);
+        memcpy(dst+filled, dst, chunk);
+        filled += chunk;
+    }
+}
+
+bool TGAImage::load_rle_data(const unsigned char *in, unsigned long size, bool reverse_rows) {
+    unsigned long bytes_per_line = width*bytespp;
+    unsigned long inpos = 0;
+    int filerow = 0;
+    unsigned long rowpixel = 0; // pixels already decoded on the current row
+    unsigned char *dst = data+(reverse_rows ? height-1 : 0)*bytes_per_line;
+    while (filerow<height) {
+        if (inpos>=size) {
             std::cerr << "an error occured while reading the data\n";
             return false;
         }
-        if (chunkheader<128) {
-            chunkheader++;
-            for (int i=0; i<chunkheader; i++) {
-                in.read((char *)colorbuffer.bgra, bytespp);
-                if (!in.good()) {
-                    std::cerr << "an error occured while reading the header\n";
-                    return false;
-                }
-                for (int t=0; t<bytespp; t++)
-                    data[currentbyte++] = colorbuffer.bgra[t];
-                currentpixel++;
-                if (currentpixel>pixelcount) {
-                    std::cerr << "Too many pixels read\n";
-                    return false;
-                }
-            }
-        } else {
-            chunkheader -= 127;
-            in.read((char *)colorbuffer.bgra, bytespp);
-            if (!in.good()) {
-                std::cerr << "an error occured while reading the header\n";
+        unsigned char chunkheader = in[inpos++];
+        bool run = chunkheader>=128;
+        unsigned long count = run ? chunkheader-127 : chunkheader+1;
+        unsigned long packet_bytes = run ? bytespp : count*bytespp;
+        if (inpos+packet_bytes>size) {
+            std::cerr << "an error occured while reading the header\n";
+            return false;
+        }
+        const unsigned char *src = in+inpos;
+        inpos += packet_bytes;
+        // A packet may span several rows, each piece goes to the row in its final position
+        while (count>0) {
+            if (filerow>=height) {
+                std::cerr << "Too many pixels read\n";
                 return false;
             }
-            for (int i=0; i<chunkheader; i++) {
-                for (int t=0; t<bytespp; t++)
-                    data[currentbyte++] = colorbuffer.bgra[t];
-                currentpixel++;
-                if (currentpixel>pixelcount) {
-                    std::cerr << "Too many pixels read\n";
-                    return false;
+            unsigned long piece = width-rowpixel;
+            if (piece>count) piece = count;
+            if (run) {
+                fill_pixels(dst+rowpixel*bytespp, src, piece, bytespp);
+            } else {
+                memcpy(dst+rowpixel*bytespp, src, piece*bytespp);
+                src += piece*bytespp;
+            }
+            count -= piece;
+            rowpixel += piece;
+            if (rowpixel==(unsigned long)width) {
+                rowpixel = 0;
+                filerow++;
+                if (filerow<height) {
+                    dst = data+(reverse_rows ? height-1-filerow : filerow)*bytes_per_line;
                 }
             }
         }
-    } while (currentpixel < pixelcount);
+    }
     return true;
 }
 
-bool TGAImage::write_tga_file(const char *filename, bool rle) {
+bool TGAImage::write_tga_file(const char *filename, bool rle, int threads) {
     unsigned char developer_area_ref[4] = {0, 0, 0, 0};
     unsigned char extension_area_ref[4] = {0, 0, 0, 0};
     unsigned char footer[18] = {'T','R','U','E','V','I','S','I','O','N','-','X','F','I','L','E','.','\0'};
@@ -174,7 +226,7 @@ bool TGAImage::write_tga_file(const char *filename, bool rle) {
             return false;
         }
     } else {
-        if (!unload_rle_data(out)) {
+        if (!unload_rle_data(out, threads)) {
             out.close();
             std::cerr << "can't unload rle data\n";
             return false;
@@ -203,44 +255,17 @@ bool TGAImage::write_tga_file(const char *filename, bool rle) {
 }
 
 // TODO: it is not necessary to break a raw chunk for two equal pixels (for the matter of the resulting size)
-bool TGAImage::unload_rle_data(std::ofstream &out) {
-    const unsigned char max_chunk_length = 128;
-    unsigned long npixels = width*height;
-    unsigned long curpix = 0;
-    while (curpix<npixels) {
-        unsigned long chunkstart = curpix*bytespp;
-        unsigned long curbyte = curpix*bytespp;
-        unsigned char run_length = 1;
-        bool raw = true;
-        while (curpix+run_length<npixels && run_length<max_chunk_length) {
-            bool succ_eq = true;
-            for (int t=0; succ_eq && t<bytespp; t++) {
-                succ_eq = (data[curbyte+t]==data[curbyte+t+bytespp]);
-            }
-            curbyte += bytespp;
-            if (1==run_length) {
-                raw = !succ_eq;
-            }
-            if (raw && succ_eq) {
-                run_length--;
-                break;
-            }
-            if (!raw && !succ_eq) {
-                break;
-            }
-            run_length++;
-        }
-        curpix += run_length;
-        out.put(raw?run_length-1:run_length+127);
-        if (!out.good()) {
-            std::cerr << "can't dump the tga file\n";
-            return false;
-        }
-        out.write((char *)(data+chunkstart), (raw?run_length*bytespp:bytespp));
-        if (!out.good()) {
-            std::cerr << "can't dump the tga file\n";
-            return false;
-        }
+bool TGAImage::unload_rle_data(std::ofstream &out, int threads) {
+    std::vector<unsigned char> packets;
+    if (threads>1) {
+        tga_rle_encode_bands(data, width, height, bytespp, threads, false, packets);
+    } else {
+        tga_rle_encode(data, width*height, bytespp, packets);
+    }
+    out.write((const char *)packets.data(), packets.size());
+    if (!out.good()) {
+        std::cerr << "can't dump the tga file\n";
+        return false;
     }
     return true;
 }
@@ -268,7 +293,7 @@ bool TGAImage::set(int x, int y, const TGAColor &c) {
     return true;
 }
 
-int TGAImage::get_bytespp() {
+int TGAImage::get_bytespp() const {
     return bytespp;
 }
 
@@ -314,6 +339,10 @@ unsigned char *TGAImage::buffer() {
     return data;
 }
 
+const unsigned char *TGAImage::buffer() const {
+    return data;
+}
+
 void TGAImage::clear() {
     memset((void *)data, 0, width*height*bytespp);
 }
@@ -354,3 +383,449 @@ bool TGAImage::scale(int w, int h) {
     height = h;
     return true;
 }
+
+
+void tga_rle_encode(const unsigned char *pixels, unsigned long npixels, int bytespp, std::vector<unsigned char> &out) {
+    const unsigned char max_chunk_length = 128;
+    unsigned long curpix = 0;
+    while (curpix<npixels) {
+        unsigned long chunkstart = curpix*bytespp;
+        unsigned long curbyte = curpix*bytespp;
+        unsigned char run_length = 1;
+        bool raw = true;
+        while (curpix+run_length<npixels && run_length<max_chunk_length) {
+            bool succ_eq = true;
+            for (int t=0; succ_eq && t<bytespp; t++) {
+                succ_eq = (pixels[curbyte+t]==pixels[curbyte+t+bytespp]);
+            }
+            curbyte += bytespp;
+            if (1==run_length) {
+                raw = !succ_eq;
+            }
+            if (raw && succ_eq) {
+                run_length--;
+                break;
+            }
+            if (!raw && !succ_eq) {
+                break;
+            }
+            run_length++;
+        }
+        curpix += run_length;
+        out.push_back(raw?run_length-1:run_length+127);
+        out.insert(out.end(), pixels+chunkstart, pixels+chunkstart+(raw?run_length*bytespp:bytespp));
+    }
+}
+
+void tga_rle_encode_bands(const unsigned char *pixels, int width, int height, int bytespp, int threads, bool row_packets, std::vector<unsigned char> &out,
+                          const TGATaskRunner &runner) {
+    int nbands = std::max(1, std::min(threads, height));
+    std::vector<std::vector<unsigned char> > bands(nbands);
+    std::vector<std::thread> workers;
+    std::vector<std::function<void()> > tasks;
+    unsigned long bytes_per_line = width*bytespp;
+    for (int b=0; b<nbands; b++) {
+        int first_row = (int)((long long)height*b/nbands);
+        int last_row = (int)((long long)height*(b+1)/nbands);
+        std::vector<unsigned char> *band = &bands[b];
+        const unsigned char *band_pixels = pixels+first_row*bytes_per_line;
+        int nrows = last_row-first_row;
+        std::function<void()> encode_band = [=]() {
+            // Worst case for raw packets: one header byte every 128 pixels
+            band->reserve(nrows*(bytes_per_line+width/128+1));
+            if (row_packets) {
+                for (int j=0; j<nrows; j++) tga_rle_encode(band_pixels+j*bytes_per_line, width, bytespp, *band);
+            } else {
+                tga_rle_encode(band_pixels, (unsigned long)nrows*width, bytespp, *band);
+            }
+        };
+        if (runner) {
+            tasks.push_back(encode_band);
+        } else if (b+1<nbands) {
+            workers.emplace_back(encode_band);
+        } else {
+            encode_band(); // the calling thread encodes the last band
+        }
+    }
+    if (runner) runner(tasks);
+    for (size_t i=0; i<workers.size(); i++) workers[i].join();
+    size_t total = out.size();
+    for (int b=0; b<nbands; b++) total += bands[b].size();
+    out.reserve(total);
+    for (int b=0; b<nbands; b++) out.insert(out.end(), bands[b].begin(), bands[b].end());
+}
+
+static const unsigned long stream_buffer_size = 1<<16;
+
+TGAStreamWriter::TGAStreamWriter(const char *filename, int w, int h, int bpp, bool rle, RowOrder order) 
+    : width(w), height(h), bytespp(bpp), rle(rle), order(order), threads(1), rows_written(0) {
+    out.open(filename, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "can't open file " << filename << "\n";
+        return;
+    }
+    TGA_Header header;
+    memset((void *)&header, 0, sizeof(header));
+    header.bitsperpixel = bytespp<<3;
+    header.width  = width;
+    header.height = height;
+    header.datatypecode = (bytespp==TGAImage::GRAYSCALE?(rle?11:3):(rle?10:2));
+    header.imagedescriptor = (order==TOP_DOWN?0x20:0x00); // origin of the first row written
+    out.write((char *)&header, sizeof(header));
+    if (!out.good()) {
+        std::cerr << "can't dump the tga file\n";
+        out.close();
+    }
+    output_buffer.reserve(stream_buffer_size + 2*width*bytespp);
+}
+
+TGAStreamWriter::~TGAStreamWriter() {
+    if (out.is_open()) close();
+}
+
+bool TGAStreamWriter::is_open() const {
+    return out.is_open();
+}
+
+int TGAStreamWriter::next_row() const {
+    return order==BOTTOM_UP ? rows_written : height-1-rows_written;
+}
+
+bool TGAStreamWriter::encode_row(const unsigned char *row) {
+    if (rle) {
+        tga_rle_encode(row, width, bytespp, output_buffer);
+    } else {
+        output_buffer.insert(output_buffer.end(), row, row+width*bytespp);
+    }
+    rows_written++;
+    return output_buffer.size()<stream_buffer_size || flush();
+}
+
+bool TGAStreamWriter::flush() {
+    if (output_buffer.empty()) return true;
+    out.write((const char *)output_buffer.data(), output_buffer.size());
+    output_buffer.clear();
+    if (!out.good()) {
+        std::cerr << "can't dump the tga file\n";
+        return false;
+    }
+    return true;
+}
+
+void TGAStreamWriter::set_threads(int n, const TGATaskRunner &runner) {
+    threads = std::max(1, n);
+    this->runner = runner;
+}
+
+bool TGAStreamWriter::write_rows(const unsigned char *rows, int count) {
+    if (!out.is_open() || rows_written+count>height) return false;
+    if (rle && threads>1 && count>1) {
+        if (!flush()) return false;
+        tga_rle_encode_bands(rows, width, count, bytespp, threads, true, output_buffer, runner);
+        rows_written += count;
+        return flush();
+    }
+    for (int j=0; j<count; j++) {
+        if (!encode_row(rows+(unsigned long)j*width*bytespp)) return false;
+    }
+    return true;
+}
+
+bool TGAStreamWriter::write_tile(int x, int y, const TGAImage &tile) {
+    if (!out.is_open() || x<0 || y<0 || x+tile.get_width()>width || y+tile.get_height()>height) {
+        return false;
+    }
+    unsigned long tile_line = tile.get_width()*bytespp;
+    if (!rle) {
+        // Uncompressed rows have a fixed size, the tile goes directly to its place in the file
+        if (!flush()) return false;
+        for (int j=0; j<tile.get_height(); j++) {
+            long file_row = (order==BOTTOM_UP ? y+j : height-1-(y+j));
+            std::streamoff offset = sizeof(TGA_Header) + ((std::streamoff)file_row*width + x)*bytespp;
+            out.seekp(offset);
+            out.write((const char *)(tile.buffer()+j*tile_line), tile_line);
+            if (!out.good()) {
+                std::cerr << "can't dump the tga file\n";
+                return false;
+            }
+        }
+        return true;
+    }
+    for (int j=0; j<tile.get_height(); j++) {
+        std::vector<unsigned char> &row = pending_rows[y+j];
+        if (row.empty()) row.resize(width*bytespp);
+        memcpy(row.data()+x*bytespp, tile.buffer()+j*tile_line, tile_line);
+        pending_coverage[y+j] += tile.get_width();
+    }
+    while (rows_written<height) {
+        std::map<int, int>::iterator coverage = pending_coverage.find(next_row());
+        if (coverage==pending_coverage.end() || coverage->second<width) break;
+        std::map<int, std::vector<unsigned char> >::iterator row = pending_rows.find(coverage->first);
+        if (!encode_row(row->second.data())) return false;
+        pending_rows.erase(row);
+        pending_coverage.erase(coverage);
+    }
+    return true;
+}
+
+bool TGAStreamWriter::close() {
+    unsigned char developer_area_ref[4] = {0, 0, 0, 0};
+    unsigned char extension_area_ref[4] = {0, 0, 0, 0};
+    unsigned char footer[18] = {'T','R','U','E','V','I','S','I','O','N','-','X','F','I','L','E','.','\0'};
+    if (!out.is_open()) return false;
+    bool success = flush();
+    if (rle && rows_written<height) {
+        std::cerr << "tga stream closed with " << height-rows_written << " missing rows\n";
+        success = false;
+    }
+    if (!rle) {
+        out.seekp(sizeof(TGA_Header) + (std::streamoff)width*height*bytespp);
+    }
+    out.write((char *)developer_area_ref, sizeof(developer_area_ref));
+    out.write((char *)extension_area_ref, sizeof(extension_area_ref));
+    out.write((char *)footer, sizeof(footer));
+    if (!out.good()) {
+        std::cerr << "can't dump the tga file\n";
+        success = false;
+    }
+    out.close();
+    return success;
+}
+
+static const unsigned char QOI_OP_INDEX = 0x00;
+static const unsigned char QOI_OP_DIFF  = 0x40;
+static const unsigned char QOI_OP_LUMA  = 0x80;
+static const unsigned char QOI_OP_RUN   = 0xc0;
+static const unsigned char QOI_OP_RGB   = 0xfe;
+static const unsigned char QOI_OP_RGBA  = 0xff;
+static const unsigned char QOI_MASK     = 0xc0;
+static const unsigned char qoi_magic[4] = {'q','o','i','f'};
+static const unsigned char qoi_padding[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+static const unsigned long qoi_header_size = 14;
+
+// QOI pixels are in RGBA order, TGA pixels in BGRA order
+struct QOIPixel {
+    unsigned char r, g, b, a;
+
+    bool operator ==(const QOIPixel &p) const { return r==p.r && g==p.g && b==p.b && a==p.a; }
+    bool operator !=(const QOIPixel &p) const { return !(*this==p); }
+};
+
+static int qoi_hash(const QOIPixel &p) {
+    return (p.r*3 + p.g*5 + p.b*7 + p.a*11) & 63;
+}
+
+static unsigned char *qoi_write_32(unsigned char *out, unsigned int v) {
+    *out++ = (unsigned char)(v>>24);
+    *out++ = (unsigned char)(v>>16);
+    *out++ = (unsigned char)(v>>8);
+    *out++ = (unsigned char)v;
+    return out;
+}
+
+static unsigned int qoi_read_32(const unsigned char *in) {
+    return ((unsigned int)in[0]<<24) | ((unsigned int)in[1]<<16) | ((unsigned int)in[2]<<8) | in[3];
+}
+
+void qoi_encode(const unsigned char *pixels, int width, int height, int bytespp, bool reverse_rows, std::vector<unsigned char> &out) {
+    int channels = (bytespp==TGAImage::RGBA ? 4 : 3);
+    unsigned long bytes_per_line = width*bytespp;
+    // Chunks are written through a pointer into space for the worst case (one RGBA chunk per pixel), trimmed at the end
+    unsigned long start = out.size();
+    out.resize(start + qoi_header_size + (unsigned long)width*height*(channels+1) + sizeof(qoi_padding));
+    unsigned char *dst = out.data()+start;
+    memcpy(dst, qoi_magic, 4);
+    dst = qoi_write_32(dst+4, width);
+    dst = qoi_write_32(dst, height);
+    *dst++ = (unsigned char)channels;
+    *dst++ = 0; // sRGB with linear alpha
+
+    QOIPixel index[64];
+    memset(index, 0, sizeof(index));
+    QOIPixel previous = {0, 0, 0, 255};
+    int run = 0;
+    for (int j=0; j<height; j++) {
+        const unsigned char *row = pixels + (reverse_rows ? height-1-j : j)*bytes_per_line;
+        for (int i=0; i<width; i++) {
+            const unsigned char *p = row + i*bytespp;
+            QOIPixel px;
+            if (1==bytespp) {
+                px.r = px.g = px.b = p[0];
+                px.a = 255;
+            } else {
+                px.r = p[2];
+                px.g = p[1];
+                px.b = p[0];
+                px.a = (4==bytespp ? p[3] : 255);
+            }
+
+            if (px==previous) {
+                run++;
+                if (62==run) {
+                    *dst++ = QOI_OP_RUN | (run-1);
+                    run = 0;
+                }
+                continue;
+            }
+            if (run>0) {
+                *dst++ = QOI_OP_RUN | (run-1);
+                run = 0;
+            }
+
+            int h = qoi_hash(px);
+            if (index[h]==px) {
+                *dst++ = QOI_OP_INDEX | h;
+            } else {
+                index[h] = px;
+                if (px.a==previous.a) {
+                    signed char vr = (signed char)(px.r-previous.r);
+                    signed char vg = (signed char)(px.g-previous.g);
+                    signed char vb = (signed char)(px.b-previous.b);
+                    signed char vg_r = (signed char)(vr-vg);
+                    signed char vg_b = (signed char)(vb-vg);
+                    if (vr>-3 && vr<2 && vg>-3 && vg<2 && vb>-3 && vb<2) {
+                        *dst++ = QOI_OP_DIFF | (vr+2)<<4 | (vg+2)<<2 | (vb+2);
+                    } else if (vg_r>-9 && vg_r<8 && vg>-33 && vg<32 && vg_b>-9 && vg_b<8) {
+                        *dst++ = QOI_OP_LUMA | (vg+32);
+                        *dst++ = (vg_r+8)<<4 | (vg_b+8);
+                    } else {
+                        *dst++ = QOI_OP_RGB;
+                        *dst++ = px.r;
+                        *dst++ = px.g;
+                        *dst++ = px.b;
+                    }
+                } else {
+                    *dst++ = QOI_OP_RGBA;
+                    *dst++ = px.r;
+                    *dst++ = px.g;
+                    *dst++ = px.b;
+                    *dst++ = px.a;
+                }
+            }
+            previous = px;
+        }
+    }
+    if (run>0) {
+        *dst++ = QOI_OP_RUN | (run-1);
+    }
+    memcpy(dst, qoi_padding, sizeof(qoi_padding));
+    dst += sizeof(qoi_padding);
+    out.resize(dst-out.data());
+}
+
+bool TGAImage::write_qoi_file(const char *filename, bool bottom_left_origin) const {
+    std::vector<unsigned char> encoded;
+    qoi_encode(data, width, height, bytespp, bottom_left_origin, encoded);
+    std::ofstream out;
+    out.open (filename, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "can't open file " << filename << "\n";
+        return false;
+    }
+    out.write((const char *)encoded.data(), encoded.size());
+    if (!out.good()) {
+        std::cerr << "can't dump the qoi file\n";
+        out.close();
+        return false;
+    }
+    out.close();
+    return true;
+}
+
+bool TGAImage::read_qoi_file(const char *filename, bool bottom_left_origin) {
+    if (data) delete [] data;
+    data = NULL;
+    std::ifstream in;
+    in.open (filename, std::ios::binary | std::ios::ate);
+    if (!in.is_open()) {
+        std::cerr << "can't open file " << filename << "\n";
+        return false;
+    }
+    std::streamsize file_size = in.tellg();
+    in.seekg(0, std::ios::beg);
+    if (file_size<(std::streamsize)(qoi_header_size+sizeof(qoi_padding))) {
+        std::cerr << "an error occured while reading the header\n";
+        return false;
+    }
+    std::vector<unsigned char> file(file_size);
+    in.read((char *)file.data(), file_size);
+    in.close();
+    if (!in) {
+        std::cerr << "an error occured while reading the data\n";
+        return false;
+    }
+    const unsigned char *header = file.data();
+    unsigned int w = qoi_read_32(header+4);
+    unsigned int h = qoi_read_32(header+8);
+    int channels = header[12];
+    if (memcmp(header, qoi_magic, 4)!=0 || w==0 || h==0 || w>32767 || h>32767 || (channels!=3 && channels!=4)) {
+        std::cerr << "bad qoi header\n";
+        return false;
+    }
+    width = w;
+    height = h;
+    bytespp = channels;
+    unsigned long bytes_per_line = width*bytespp;
+    data = new unsigned char[bytes_per_line*height];
+
+    QOIPixel index[64];
+    memset(index, 0, sizeof(index));
+    QOIPixel px = {0, 0, 0, 255};
+    int run = 0;
+    unsigned long p = qoi_header_size;
+    unsigned long chunks_end = file.size()-sizeof(qoi_padding);
+    for (int j=0; j<height; j++) {
+        unsigned char *row = data + (bottom_left_origin ? height-1-j : j)*bytes_per_line;
+        for (int i=0; i<width; i++) {
+            if (run>0) {
+                run--;
+            } else if (p<chunks_end) {
+                unsigned char b1 = file[p++];
+                if (QOI_OP_RGB==b1) {
+                    if (p+3>chunks_end) {
+                        std::cerr << "an error occured while reading the data\n";
+                        return false;
+                    }
+                    px.r = file[p++];
+                    px.g = file[p++];
+                    px.b = file[p++];
+                } else if (QOI_OP_RGBA==b1) {
+                    if (p+4>chunks_end) {
+                        std::cerr << "an error occured while reading the data\n";
+                        return false;
+                    }
+                    px.r = file[p++];
+                    px.g = file[p++];
+                    px.b = file[p++];
+                    px.a = file[p++];
+                } else if (QOI_OP_INDEX==(b1 & QOI_MASK)) {
+                    px = index[b1];
+                } else if (QOI_OP_DIFF==(b1 & QOI_MASK)) {
+                    px.r += ((b1>>4) & 0x03) - 2;
+                    px.g += ((b1>>2) & 0x03) - 2;
+                    px.b += ( b1     & 0x03) - 2;
+                } else if (QOI_OP_LUMA==(b1 & QOI_MASK)) {
+                    if (p+1>chunks_end) {
+                        std::cerr << "an error occured while reading the data\n";
+                        return false;
+                    }
+                    unsigned char b2 = file[p++];
+                    int vg = (b1 & 0x3f) - 32;
+                    px.r += vg - 8 + ((b2>>4) & 0x0f);
+                    px.g += vg;
+                    px.b += vg - 8 +  (b2     & 0x0f);
+                } else {
+                    run = b1 & 0x3f;
+                }
+                index[qoi_hash(px)] = px;
+            }
+            unsigned char *dst = row + i*bytespp;
+            dst[0] = px.b;
+            dst[1] = px.g;
+            dst[2] = px.r;
+            if (4==bytespp) dst[3] = px.a;
+        }
+    }
+    std::cerr << width << "x" << height << "/" << bytespp*8 << "\n";
+    return true;
+}
@@ -2,6 +2,9 @@
 #define __IMAGE_H__
 
 #include <fstream>
+#include <functional>
+#include <map>
+#include <vector>
 
 #pragma pack(push,1)
 struct TGA_Header {
@@ -13,8 +16,8 @@ struct TGA_Header {
     char colormapdepth;
     short x_origin;
     short y_origin;
-    short width;
-    short height;
+    unsigned short width;
+    unsigned short height;
     char  bitsperpixel;
     char  imagedescriptor;
 };
@@ -70,8 +73,8 @@ protected:
     int height;
     int bytespp;
 
-    bool   load_rle_data(std::ifstream &in);
-    bool unload_rle_data(std::ofstream &out);
+    bool   load_rle_data(const unsigned char *in, unsigned long size, bool reverse_rows);
+    bool unload_rle_data(std::ofstream &out, int threads);
 public:
     enum Format {
         GRAYSCALE=1, RGB=3, RGBA=4
@@ -80,8 +83,16 @@ public:
     TGAImage();
     TGAImage(int w, int h, int bpp);
     TGAImage(const TGAImage &img);
-    bool read_tga_file(const char *filename);
-    bool write_tga_file(const char *filename, bool rle=true);
+    // Moves hand the pixel buffer over, leaving an empty image behind
+    TGAImage(TGAImage &&img);
+    // Rows are stored with the top-left origin by default, or with the bottom-left origin used by the renderer
+    bool read_tga_file(const char *filename, bool bottom_left_origin=false);
+    // With threads>1, the RLE packets are encoded in parallel row bands and never cross a band boundary
+    bool write_tga_file(const char *filename, bool rle=true, int threads=1);
+    // Lossless QOI ("Quite OK Image") files; QOI rows are always stored from the top of the image.
+    // Grayscale images are written as RGB, and files are read back as RGB or RGBA images.
+    bool read_qoi_file(const char *filename, bool bottom_left_origin=false);
+    bool write_qoi_file(const char *filename, bool bottom_left_origin=false) const;
     bool flip_horizontally();
     bool flip_vertically();
     bool scale(int w, int h);
@@ -90,11 +101,67 @@ public:
     bool set(int x, int y, const TGAColor &c);
     ~TGAImage();
     TGAImage & operator =(const TGAImage &img);
+    TGAImage & operator =(TGAImage &&img);
     int get_width() const;
     int get_height() const;
-    int get_bytespp();
+    int get_bytespp() const;
     unsigned char *buffer();
+    const unsigned char *buffer() const;
     void clear();
 };
 
+// Run-length encode npixels pixels with the packet layout of TGAImage::write_tga_file, appending the packets to out
+void tga_rle_encode(const unsigned char *pixels, unsigned long npixels, int bytespp, std::vector<unsigned char> &out);
+
+// Runs the given tasks, possibly concurrently, and returns once all of them are finished
+typedef std::function<void(std::vector<std::function<void()> > &)> TGATaskRunner;
+
+// Run-length encode an image split into one band of rows per thread, encoded in parallel and concatenated.
+// Packets never cross band boundaries (nor rows, with row_packets), so the output is byte-identical to a
+// serial encode of each band (or row) in sequence. The bands run on the runner if given, else on new threads.
+void tga_rle_encode_bands(const unsigned char *pixels, int width, int height, int bytespp, int threads, bool row_packets, std::vector<unsigned char> &out,
+                          const TGATaskRunner &runner=TGATaskRunner());
+
+// QOI encode the image (header, chunks and end marker), appending to out; with reverse_rows the last row is encoded first
+void qoi_encode(const unsigned char *pixels, int width, int height, int bytespp, bool reverse_rows, std::vector<unsigned char> &out);
+
+// Writes a TGA file as its rows are produced, without holding the complete image in memory.
+// Rows are numbered from the bottom of the image, as produced by the renderer. The order in which
+// rows are encoded is declared up front and sets the origin bit of the header, so no flip is needed.
+// With RLE, packets never cross rows; without RLE, tiles are written directly at their file offset.
+class TGAStreamWriter {
+public:
+    enum RowOrder {
+        BOTTOM_UP, TOP_DOWN
+    };
+
+    TGAStreamWriter(const char *filename, int w, int h, int bpp, bool rle=true, RowOrder order=BOTTOM_UP);
+    ~TGAStreamWriter();
+    bool is_open() const;
+    // Next rows in the declared order, each one width*bpp bytes
+    bool write_rows(const unsigned char *rows, int count);
+    // Tiles may arrive in any order; rows are encoded as soon as they are complete and next in the declared order
+    bool write_tile(int x, int y, const TGAImage &tile);
+    bool close();
+    // Number of threads used to encode the rows given to write_rows, and optionally the runner of their tasks
+    void set_threads(int n, const TGATaskRunner &runner=TGATaskRunner());
+protected:
+    std::ofstream out;
+    int width;
+    int height;
+    int bytespp;
+    bool rle;
+    RowOrder order;
+    int threads;
+    TGATaskRunner runner;
+    int rows_written;
+    std::map<int, std::vector<unsigned char> > pending_rows; // partially or completely filled rows not encoded yet
+    std::map<int, int> pending_coverage; // number of pixels filled on each pending row
+    std::vector<unsigned char> output_buffer;
+
+    int next_row() const;
+    bool encode_row(const unsigned char *row);
+    bool flush();
+};
+
 #endif //__IMAGE_H__